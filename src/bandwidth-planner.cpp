@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bandwidth-planner.hpp"
+
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+BandwidthPlanner::BandwidthPlanner(double linkCapacity, double headroom) noexcept
+    : m_linkCapacity{linkCapacity}
+    , m_headroom{headroom} {
+}
+
+bool BandwidthPlanner::plan(const std::vector<Demand> &demands, std::vector<Allocation> &allocations) noexcept {
+    const double BYTES_PER_MBIT{1000000.0 / 8.0};
+    const double USABLE{m_linkCapacity * (1.0 - m_headroom)};
+
+    std::map<std::string, std::vector<uint32_t>> links;
+    for (uint32_t i{0}; i < demands.size(); i++) {
+        links[demands[i].link].push_back(i);
+    }
+
+    bool retVal{true};
+    std::stringstream sstr;
+    sstr << std::fixed << std::setprecision(1);
+    allocations.assign(demands.size(), Allocation{});
+    for (auto &link : links) {
+        double total{0};
+        for (auto i : link.second) {
+            total += demands[i].required;
+        }
+        const bool FITS{total <= USABLE};
+        retVal = retVal && FITS;
+        sstr << "link '" << link.first << "': " << total / BYTES_PER_MBIT << " of " << USABLE / BYTES_PER_MBIT << " Mbit/s usable" << (FITS ? "" : " (exceeded)") << std::endl;
+
+        const double SPARE{FITS ? USABLE - total : 0.0};
+        uint32_t slot{0};
+        for (auto i : link.second) {
+            Allocation &allocation{allocations[i]};
+            allocation.serialNumber = demands[i].serialNumber;
+            allocation.limit        = demands[i].required + ((0 < total) ? SPARE * demands[i].required / total : 0.0);
+            // Spread the bursts of the cameras on one link over the frame period.
+            allocation.startOffset  = (0 < demands[i].fps) ? static_cast<int64_t>(1000000.0 / demands[i].fps * slot / link.second.size()) : 0;
+            slot++;
+            sstr << "  camera '" << demands[i].serialNumber << "': requires " << demands[i].required / BYTES_PER_MBIT << " Mbit/s, limited to " << allocation.limit / BYTES_PER_MBIT << " Mbit/s, starts at +" << allocation.startOffset / 1000 << " ms" << std::endl;
+        }
+    }
+    m_report = sstr.str();
+    return retVal;
+}
+
+std::string BandwidthPlanner::report() const noexcept {
+    return m_report;
+}
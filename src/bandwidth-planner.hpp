@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BANDWIDTH_PLANNER_HPP
+#define BANDWIDTH_PLANNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Distributes the capacity of the network links among the cameras sharing
+ * them: every camera gets its required throughput plus a share of the spare
+ * capacity proportional to its demand, and the cameras on the same link are
+ * assigned evenly spaced start times within their frame period.
+ */
+class BandwidthPlanner {
+   public:
+    struct Demand {
+        uint32_t serialNumber{0};
+        // Interface the camera is connected to.
+        std::string link{};
+        // Throughput on the wire in bytes per second.
+        double required{0};
+        double fps{0};
+    };
+
+    struct Allocation {
+        uint32_t serialNumber{0};
+        // Throughput limit in bytes per second.
+        double limit{0};
+        // Start offset within the frame period in microseconds.
+        int64_t startOffset{0};
+    };
+
+   private:
+    BandwidthPlanner(const BandwidthPlanner &) = delete;
+    BandwidthPlanner(BandwidthPlanner &&)      = delete;
+    BandwidthPlanner &operator=(const BandwidthPlanner &) = delete;
+    BandwidthPlanner &operator=(BandwidthPlanner &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param linkCapacity Capacity of each link in bytes per second.
+     * @param headroom Fraction of the capacity that is kept free.
+     */
+    BandwidthPlanner(double linkCapacity, double headroom) noexcept;
+    ~BandwidthPlanner() = default;
+
+   public:
+    /**
+     * This method plans the throughput of all cameras.
+     *
+     * @param demands Demands of all cameras.
+     * @param allocations Resulting allocations in the order of demands.
+     * @return true if the demands of all links fit their capacity.
+     */
+    bool plan(const std::vector<Demand> &demands, std::vector<Allocation> &allocations) noexcept;
+
+    /**
+     * @return Human-readable summary of the last plan.
+     */
+    std::string report() const noexcept;
+
+   private:
+    const double m_linkCapacity;
+    const double m_headroom;
+    std::string m_report{};
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "conversion-kernels.hpp"
+
+#include <libyuv.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Time in milliseconds of one call of the conversion, as the best mean of
+// three rounds after a warm-up.
+static double millisecondsPerFrame(uint32_t iterations, const std::function<void()> &conversion) noexcept {
+    const uint32_t ROUNDS{3};
+    conversion();
+    double retVal{0.0};
+    for (uint32_t round{0}; round < ROUNDS; round++) {
+        const auto START{std::chrono::steady_clock::now()};
+        for (uint32_t i{0}; i < iterations; i++) {
+            conversion();
+        }
+        const double MEAN{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - START).count() / iterations};
+        retVal = ((0 == round) || (MEAN < retVal)) ? MEAN : retVal;
+    }
+    return retVal;
+}
+
+static void report(const std::string &name, double before, double after) noexcept {
+    std::cout << std::fixed << std::setprecision(2) << "[benchmark-conversion]: " << name << ": libyuv " << before << " ms, fused " << after << " ms per frame (speed-up " << (before / after) << ")." << std::endl;
+}
+
+int32_t main(int32_t argc, char **argv) {
+    auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    if (0 != commandlineArguments.count("help")) {
+        std::cerr << argv[0] << " times the single-threaded conversion of a camera frame into I420 and ARGB by libyuv against the fused kernels." << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " [--width=1920] [--height=1200] [--iterations=200]" << std::endl;
+        return 1;
+    }
+    const uint32_t WIDTH{(commandlineArguments.count("width") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["width"])) : 1920};
+    const uint32_t HEIGHT{(commandlineArguments.count("height") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["height"])) : 1200};
+    const uint32_t ITERATIONS{(commandlineArguments.count("iterations") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["iterations"])) : 200};
+    if ((0 == WIDTH) || (0 != WIDTH % 2) || (0 == HEIGHT) || (0 == ITERATIONS)) {
+        std::cerr << "[benchmark-conversion]: Width must be even and positive." << std::endl;
+        return 1;
+    }
+
+    // Frames larger than the caches make the memory traffic dominate as it does in the service.
+    const int32_t W{static_cast<int32_t>(WIDTH)};
+    const int32_t H{static_cast<int32_t>(HEIGHT)};
+    std::vector<uint8_t> uyvy(2 * WIDTH * HEIGHT);
+    for (uint32_t i{0}; i < uyvy.size(); i++) {
+        uyvy[i] = static_cast<uint8_t>((i * 7 + i / (2 * WIDTH)) & 0xFF);
+    }
+    std::vector<uint8_t> i420(WIDTH * HEIGHT + 2 * (WIDTH / 2) * ((HEIGHT + 1) / 2));
+    std::vector<uint8_t> argb(4 * WIDTH * HEIGHT);
+    uint8_t *y{i420.data()};
+    uint8_t *u{y + WIDTH * HEIGHT};
+    uint8_t *v{u + (WIDTH / 2) * ((HEIGHT + 1) / 2)};
+
+    std::cout << "[benchmark-conversion]: " << WIDTH << "x" << HEIGHT << ", " << ITERATIONS << " iterations." << std::endl;
+
+    // UYVY: libyuv reads the I420 frame back to produce ARGB; the fused kernel
+    // reads the camera frame once and writes both outputs.
+    const double UYVY_LIBYUV{millisecondsPerFrame(ITERATIONS, [&]() {
+        libyuv::UYVYToI420(uyvy.data(), 2 * W, y, W, u, W / 2, v, W / 2, W, H);
+        libyuv::I420ToARGB(y, W, u, W / 2, v, W / 2, argb.data(), 4 * W, W, H);
+    })};
+    const double UYVY_FUSED{millisecondsPerFrame(ITERATIONS, [&]() {
+        kernels::uyvyToI420AndARGB(uyvy.data(), 2 * WIDTH, y, WIDTH, u, WIDTH / 2, v, WIDTH / 2, argb.data(), 4 * WIDTH, WIDTH, HEIGHT);
+    })};
+    report("UYVY to I420 and ARGB", UYVY_LIBYUV, UYVY_FUSED);
+
+    // Mono8: libyuv rewrites the neutral chroma planes of every frame and
+    // reads them back for ARGB; the converter fills them once per buffer,
+    // then copies the Y plane and expands grey to ARGB directly.
+    std::vector<uint8_t> grey(WIDTH * HEIGHT);
+    for (uint32_t i{0}; i < grey.size(); i++) {
+        grey[i] = static_cast<uint8_t>((i * 7 + i / WIDTH) & 0xFF);
+    }
+    const double MONO_LIBYUV{millisecondsPerFrame(ITERATIONS, [&]() {
+        libyuv::I400ToI420(grey.data(), W, y, W, u, W / 2, v, W / 2, W, H);
+        libyuv::I420ToARGB(y, W, u, W / 2, v, W / 2, argb.data(), 4 * W, W, H);
+    })};
+    std::memset(u, 128, (WIDTH / 2) * ((HEIGHT + 1) / 2));
+    std::memset(v, 128, (WIDTH / 2) * ((HEIGHT + 1) / 2));
+    const double MONO_FUSED{millisecondsPerFrame(ITERATIONS, [&]() {
+        std::memcpy(y, grey.data(), grey.size());
+        kernels::greyToARGB(grey.data(), WIDTH, argb.data(), 4 * WIDTH, WIDTH, HEIGHT);
+    })};
+    report("Mono8 to I420 and ARGB", MONO_LIBYUV, MONO_FUSED);
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "camera-discovery.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+CameraDiscovery::CameraDiscovery(Spinnaker::InterfaceList &listOfInterfaces, const std::string &cacheFile) noexcept
+    : m_listOfInterfaces{listOfInterfaces}
+    , m_cacheFile{cacheFile} {
+    for (uint32_t i{0}; i < m_listOfInterfaces.GetSize(); i++) {
+        m_interfaceIds.push_back(interfaceId(i));
+    }
+    loadCache();
+}
+
+std::map<uint32_t, Spinnaker::CameraPtr> CameraDiscovery::find(const std::vector<uint32_t> &serialNumbers, std::chrono::milliseconds timeout) noexcept {
+    const auto DEADLINE{std::chrono::steady_clock::now() + timeout};
+    m_cameras.clear();
+    m_complete.store(serialNumbers.empty());
+
+    // Try the interfaces on which the cameras were found the last time first.
+    std::vector<uint32_t> cachedInterfaces;
+    bool allCached{!serialNumbers.empty()};
+    for (auto serialNumber : serialNumbers) {
+        auto it = m_cache.find(serialNumber);
+        auto position = (m_cache.end() != it) ? std::find(m_interfaceIds.begin(), m_interfaceIds.end(), it->second) : m_interfaceIds.end();
+        if (m_interfaceIds.end() == position) {
+            allCached = false;
+            continue;
+        }
+        const uint32_t INDEX{static_cast<uint32_t>(position - m_interfaceIds.begin())};
+        if (cachedInterfaces.end() == std::find(cachedInterfaces.begin(), cachedInterfaces.end(), INDEX)) {
+            cachedInterfaces.push_back(INDEX);
+        }
+    }
+    if (allCached) {
+        const auto CACHED_DEADLINE{std::min(DEADLINE, std::chrono::steady_clock::now() + std::chrono::milliseconds(500))};
+        poll(cachedInterfaces, serialNumbers, CACHED_DEADLINE);
+    }
+
+    if (!m_complete.load()) {
+        std::vector<uint32_t> allInterfaces;
+        for (uint32_t i{0}; i < m_listOfInterfaces.GetSize(); i++) {
+            allInterfaces.push_back(i);
+        }
+        poll(allInterfaces, serialNumbers, DEADLINE);
+    }
+
+    saveCache();
+    return m_cameras;
+}
+
+void CameraDiscovery::poll(const std::vector<uint32_t> &interfaces, const std::vector<uint32_t> &serialNumbers, std::chrono::steady_clock::time_point deadline) noexcept {
+    std::vector<std::thread> pollers;
+    for (auto index : interfaces) {
+        pollers.push_back(std::thread(&CameraDiscovery::pollInterface, this, index, serialNumbers, deadline));
+    }
+    for (auto &poller : pollers) {
+        poller.join();
+    }
+}
+
+void CameraDiscovery::pollInterface(uint32_t index, const std::vector<uint32_t> &serialNumbers, std::chrono::steady_clock::time_point deadline) noexcept {
+    // Cameras may need a moment to answer after a restart; hence, the
+    // interface is polled until all cameras are found or time is up.
+    const auto POLL_INTERVAL{std::chrono::milliseconds(50)};
+    while (!m_complete.load()) {
+        try {
+            Spinnaker::InterfacePtr interfacePtr{m_listOfInterfaces.GetByIndex(index)};
+            interfacePtr->UpdateCameras();
+            Spinnaker::CameraList listOfCameras{interfacePtr->GetCameras()};
+            for (uint32_t j{0}; j < listOfCameras.GetSize(); j++) {
+                try {
+                    Spinnaker::CameraPtr cam{listOfCameras.GetByIndex(j)};
+                    Spinnaker::GenApi::INodeMap &cameraNodeMap{cam->GetTLDeviceNodeMap()};
+                    Spinnaker::GenApi::CStringPtr ptrDeviceSerialNumber{cameraNodeMap.GetNode("DeviceSerialNumber")};
+                    if (Spinnaker::GenApi::IsAvailable(ptrDeviceSerialNumber) && Spinnaker::GenApi::IsReadable(ptrDeviceSerialNumber)) {
+                        std::string serialNumber{ptrDeviceSerialNumber->ToString()};
+                        uint32_t foundSerialNumber{static_cast<uint32_t>(std::stoul(serialNumber))};
+                        if (serialNumbers.end() != std::find(serialNumbers.begin(), serialNumbers.end(), foundSerialNumber)) {
+                            std::lock_guard<std::mutex> lck(m_mutex);
+                            if (0 == m_cameras.count(foundSerialNumber)) {
+                                m_cameras[foundSerialNumber] = cam;
+                                m_cache[foundSerialNumber]   = m_interfaceIds[index];
+                                std::clog << "[opendlv-device-camera-spinnaker]: Found camera '" << foundSerialNumber << "' on interface " << index << " (" << m_interfaceIds[index] << ")." << std::endl;
+                                if (serialNumbers.size() == m_cameras.size()) {
+                                    m_complete.store(true);
+                                    m_found.notify_all();
+                                }
+                            }
+                        }
+                    }
+                }
+                catch (...) {
+                    // Camera not accessible.
+                }
+            }
+        }
+        catch (...) {
+            // Interface not accessible.
+        }
+
+        std::unique_lock<std::mutex> lck(m_mutex);
+        const auto WAKEUP{std::min(deadline, std::chrono::steady_clock::now() + POLL_INTERVAL)};
+        if (m_found.wait_until(lck, WAKEUP, [this]() { return m_complete.load(); }) || (std::chrono::steady_clock::now() >= deadline)) {
+            break;
+        }
+    }
+}
+
+std::string CameraDiscovery::interfaceOf(uint32_t serialNumber) noexcept {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    auto it = m_cache.find(serialNumber);
+    return (m_cache.end() != it) ? it->second : "";
+}
+
+std::string CameraDiscovery::interfaceId(uint32_t index) noexcept {
+    try {
+        Spinnaker::InterfacePtr interfacePtr{m_listOfInterfaces.GetByIndex(index)};
+        Spinnaker::GenApi::CStringPtr ptrInterfaceId{interfacePtr->GetTLNodeMap().GetNode("InterfaceID")};
+        if (Spinnaker::GenApi::IsAvailable(ptrInterfaceId) && Spinnaker::GenApi::IsReadable(ptrInterfaceId)) {
+            return std::string{ptrInterfaceId->GetValue().c_str()};
+        }
+    }
+    catch (...) {
+        // Fall back to the index.
+    }
+    return std::to_string(index);
+}
+
+void CameraDiscovery::loadCache() noexcept {
+    if (!m_cacheFile.empty()) {
+        // One "<serial number> <interface ID>" per line.
+        std::ifstream cache{m_cacheFile};
+        std::string line;
+        while (std::getline(cache, line)) {
+            const auto SEPARATOR{line.find(' ')};
+            if ((std::string::npos != SEPARATOR) && (0 < SEPARATOR)) {
+                try {
+                    m_cache[static_cast<uint32_t>(std::stoul(line.substr(0, SEPARATOR)))] = line.substr(SEPARATOR + 1);
+                }
+                catch (...) {
+                    // Skip malformed entries.
+                }
+            }
+        }
+    }
+}
+
+void CameraDiscovery::saveCache() noexcept {
+    if (!m_cacheFile.empty()) {
+        std::ofstream cache{m_cacheFile, std::ios::trunc};
+        for (auto &entry : m_cache) {
+            cache << entry.first << " " << entry.second << std::endl;
+        }
+        if (!cache.good()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Could not write discovery cache '" << m_cacheFile << "'." << std::endl;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAMERA_DISCOVERY_HPP
+#define CAMERA_DISCOVERY_HPP
+
+#include <Spinnaker.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Finds cameras by their serial numbers. All interfaces are polled in
+ * parallel until every requested camera is found or a timeout expires.
+ * Optionally, the interface on which each camera was found is kept in a
+ * cache file; the cached interfaces are polled first on the next start.
+ */
+class CameraDiscovery {
+   private:
+    CameraDiscovery(const CameraDiscovery &) = delete;
+    CameraDiscovery(CameraDiscovery &&)      = delete;
+    CameraDiscovery &operator=(const CameraDiscovery &) = delete;
+    CameraDiscovery &operator=(CameraDiscovery &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param listOfInterfaces Interfaces of the Spinnaker system.
+     * @param cacheFile File with the serial number to interface mapping; empty for none.
+     */
+    CameraDiscovery(Spinnaker::InterfaceList &listOfInterfaces, const std::string &cacheFile) noexcept;
+    ~CameraDiscovery() = default;
+
+   public:
+    /**
+     * This method finds the cameras with the given serial numbers.
+     *
+     * @param serialNumbers Serial numbers of the cameras to find.
+     * @param timeout Maximum time to wait for the cameras to show up.
+     * @return Found cameras by serial number.
+     */
+    std::map<uint32_t, Spinnaker::CameraPtr> find(const std::vector<uint32_t> &serialNumbers, std::chrono::milliseconds timeout) noexcept;
+
+    /**
+     * @param serialNumber Serial number of a found camera.
+     * @return ID of the interface the camera was found on; empty if unknown.
+     */
+    std::string interfaceOf(uint32_t serialNumber) noexcept;
+
+   private:
+    void poll(const std::vector<uint32_t> &interfaces, const std::vector<uint32_t> &serialNumbers, std::chrono::steady_clock::time_point deadline) noexcept;
+    void pollInterface(uint32_t index, const std::vector<uint32_t> &serialNumbers, std::chrono::steady_clock::time_point deadline) noexcept;
+    std::string interfaceId(uint32_t index) noexcept;
+    void loadCache() noexcept;
+    void saveCache() noexcept;
+
+   private:
+    Spinnaker::InterfaceList &m_listOfInterfaces;
+    const std::string m_cacheFile;
+    std::vector<std::string> m_interfaceIds{};
+    // Interface ID by serial number.
+    std::map<uint32_t, std::string> m_cache{};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_found{};
+    std::map<uint32_t, Spinnaker::CameraPtr> m_cameras{};
+    std::atomic<bool> m_complete{false};
+};
+
+#endif
@@ -0,0 +1,1077 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "camera-pipeline.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include "shared-memory-layout.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// Enables the chunks that describe the camera state per frame.
+static bool enableChunkData(Spinnaker::GenApi::INodeMap &nodeMap) {
+    bool retVal{false};
+    try {
+        Spinnaker::GenApi::CBooleanPtr chunkModeActive = nodeMap.GetNode("ChunkModeActive");
+        Spinnaker::GenApi::CEnumerationPtr chunkSelector = nodeMap.GetNode("ChunkSelector");
+        if (IsAvailable(chunkModeActive) && IsWritable(chunkModeActive) && IsAvailable(chunkSelector) && IsWritable(chunkSelector)) {
+            chunkModeActive->SetValue(true);
+            retVal = true;
+            for (auto chunk : {"FrameID", "Timestamp", "ExposureTime", "Gain"}) {
+                Spinnaker::GenApi::CEnumEntryPtr entry = chunkSelector->GetEntryByName(chunk);
+                if (IsAvailable(entry) && IsReadable(entry)) {
+                    chunkSelector->SetIntValue(entry->GetValue());
+                    Spinnaker::GenApi::CBooleanPtr chunkEnable = nodeMap.GetNode("ChunkEnable");
+                    if (IsAvailable(chunkEnable) && IsWritable(chunkEnable)) {
+                        chunkEnable->SetValue(true);
+                        continue;
+                    }
+                }
+                std::cerr << "[opendlv-device-camera-spinnaker]: Chunk " << chunk << " not available." << std::endl;
+                retVal = false;
+            }
+        }
+    }
+    catch (...) {
+        retVal = false;
+    }
+    return retVal;
+}
+
+// Sets an enumeration node to the entry with the given name.
+static bool setEnumeration(Spinnaker::GenApi::INodeMap &nodeMap, const std::string &node, const std::string &entry) {
+    try {
+        Spinnaker::GenApi::CEnumerationPtr enumeration = nodeMap.GetNode(node.c_str());
+        if (IsAvailable(enumeration) && IsWritable(enumeration)) {
+            Spinnaker::GenApi::CEnumEntryPtr value = enumeration->GetEntryByName(entry.c_str());
+            if (IsAvailable(value) && IsReadable(value)) {
+                enumeration->SetIntValue(value->GetValue());
+                return true;
+            }
+        }
+    }
+    catch (...) {
+        // Node not supported by this camera.
+    }
+    std::cerr << "[opendlv-device-camera-spinnaker]: Could not set " << node << " to " << entry << "." << std::endl;
+    return false;
+}
+
+// Size and pixel format of a frame in an additional output format.
+static std::pair<uint32_t, uint32_t> frameSizeAndFourcc(CameraPipeline::OutputFormat format, uint32_t width, uint32_t height) {
+    switch (format) {
+        case CameraPipeline::OutputFormat::NV12: return {width * height * 3 / 2, layout::fourcc('N', 'V', '1', '2')};
+        case CameraPipeline::OutputFormat::BGR24: return {width * height * 3, layout::fourcc('B', 'G', 'R', '3')};
+        case CameraPipeline::OutputFormat::RGB24: return {width * height * 3, layout::fourcc('R', 'G', 'B', '3')};
+        case CameraPipeline::OutputFormat::RGB_PLANAR: return {width * height * 3, layout::fourcc('R', 'G', 'B', 'P')};
+        case CameraPipeline::OutputFormat::UYVY: return {width * height * 2, layout::fourcc('U', 'Y', 'V', 'Y')};
+    }
+    return {0, 0};
+}
+
+// Tells whether an area has an active reader and reports when this changes.
+static bool updateDemand(const SharedMemoryArea &area, int64_t timeout, bool &demanded) {
+    const bool DEMANDED{area.hasActiveReaders(timeout)};
+    if (DEMANDED != demanded) {
+        demanded = DEMANDED;
+        std::clog << "[opendlv-device-camera-spinnaker]: " << (DEMANDED ? "Resuming" : "Pausing") << " output to '" << area.name() << "' " << (DEMANDED ? "for a new reader." : "without active readers.") << std::endl;
+    }
+    return demanded;
+}
+
+bool CameraPipeline::outputFormatFromString(const std::string &format, OutputFormat &outputFormat) noexcept {
+    if ("nv12" == format) {
+        outputFormat = OutputFormat::NV12;
+    } else if ("bgr24" == format) {
+        outputFormat = OutputFormat::BGR24;
+    } else if ("rgb24" == format) {
+        outputFormat = OutputFormat::RGB24;
+    } else if ("rgbp" == format) {
+        outputFormat = OutputFormat::RGB_PLANAR;
+    } else if ("uyvy" == format) {
+        outputFormat = OutputFormat::UYVY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CameraPipeline::CameraPipeline(const Configuration &configuration, WorkerPool &workerPool, cluon::OD4Session *od4, FrameSetArea *frameSetArea, std::function<Spinnaker::CameraPtr(uint32_t)> findCamera) noexcept
+    : m_configuration{configuration}
+    , m_workerPool{workerPool}
+    , m_od4{od4}
+    , m_frameSetArea{frameSetArea}
+    , m_findCamera{findCamera} {
+}
+
+CameraPipeline::~CameraPipeline() {
+    stop();
+    if (nullptr != m_display) {
+        XCloseDisplay(m_display);
+    }
+}
+
+uint32_t CameraPipeline::serialNumber() const noexcept {
+    return m_configuration.serialNumber;
+}
+
+const CameraPipeline::Configuration &CameraPipeline::configuration() const noexcept {
+    return m_configuration;
+}
+
+double CameraPipeline::requiredThroughput() noexcept {
+    // IP, UDP, and GVSP headers per packet plus Ethernet framing, preamble, and gap.
+    const double HEADERS{36.0};
+    const double FRAMING{38.0};
+    double retVal{0};
+    std::lock_guard<std::mutex> lck(m_cameraMutex);
+    try {
+        const double PAYLOAD_SIZE{static_cast<double>(m_camera->PayloadSize.GetValue())};
+        double packetSize{1500.0};
+        Spinnaker::GenApi::CIntegerPtr packetSizeNode = m_camera->GetNodeMap().GetNode("GevSCPSPacketSize");
+        if (IsAvailable(packetSizeNode) && IsReadable(packetSizeNode)) {
+            packetSize = static_cast<double>(packetSizeNode->GetValue());
+        }
+        const double PACKETS{PAYLOAD_SIZE / (packetSize - HEADERS)};
+        retVal = (PAYLOAD_SIZE + PACKETS * (HEADERS + FRAMING)) * static_cast<double>(m_configuration.fps);
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not determine the throughput of camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+    }
+    return retVal;
+}
+
+bool CameraPipeline::limitThroughput(double bytesPerSecond, double linkCapacity) noexcept {
+    std::lock_guard<std::mutex> lck(m_cameraMutex);
+    m_throughputLimit = static_cast<int64_t>(bytesPerSecond);
+    try {
+        Spinnaker::GenApi::INodeMap &nodeMap{m_camera->GetNodeMap()};
+        Spinnaker::GenApi::CIntegerPtr limit = nodeMap.GetNode("DeviceLinkThroughputLimit");
+        if (IsAvailable(limit) && IsWritable(limit)) {
+            limit->SetValue(std::min(std::max(m_throughputLimit, limit->GetMin()), limit->GetMax()));
+            std::clog << "[opendlv-device-camera-spinnaker]: Throughput of camera '" << m_configuration.serialNumber << "' limited to " << limit->GetValue() << " bytes/s." << std::endl;
+            return true;
+        }
+
+        // Without a throughput limit, the gap between two packets stretches
+        // a packet's transmission time to its share of the link.
+        Spinnaker::GenApi::CIntegerPtr packetSize = nodeMap.GetNode("GevSCPSPacketSize");
+        Spinnaker::GenApi::CIntegerPtr packetDelay = nodeMap.GetNode("GevSCPD");
+        if (IsAvailable(packetSize) && IsReadable(packetSize) && IsAvailable(packetDelay) && IsWritable(packetDelay)) {
+            double tickFrequency{1000000000.0};
+            Spinnaker::GenApi::CIntegerPtr tickFrequencyNode = nodeMap.GetNode("GevTimestampTickFrequency");
+            if (IsAvailable(tickFrequencyNode) && IsReadable(tickFrequencyNode)) {
+                tickFrequency = static_cast<double>(tickFrequencyNode->GetValue());
+            }
+            const double PACKET_SIZE{static_cast<double>(packetSize->GetValue())};
+            const double GAP{std::max(0.0, PACKET_SIZE / bytesPerSecond - PACKET_SIZE / linkCapacity)};
+            const int64_t DELAY{static_cast<int64_t>(GAP * tickFrequency)};
+            packetDelay->SetValue(std::min(std::max(DELAY, packetDelay->GetMin()), packetDelay->GetMax()));
+            m_packetDelay        = packetDelay->GetValue();
+            m_minimumPacketDelay = m_packetDelay;
+            std::clog << "[opendlv-device-camera-spinnaker]: Throughput of camera '" << m_configuration.serialNumber << "' limited by an inter-packet delay of " << m_packetDelay << " ticks." << std::endl;
+            return true;
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not limit the throughput of camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+    }
+    return false;
+}
+
+void CameraPipeline::setStartPhase(std::chrono::steady_clock::time_point epoch, int64_t offset) noexcept {
+    m_startEpoch  = epoch;
+    m_startOffset = offset;
+}
+
+// The phase is taken from the host clock; free-running cameras follow their
+// own clocks and drift away from it until their acquisition restarts.
+void CameraPipeline::waitForStartPhase() noexcept {
+    if ((0 > m_startOffset) || (0.0f >= m_configuration.fps)) {
+        return;
+    }
+    const int64_t PERIOD{static_cast<int64_t>(1000000.0 / m_configuration.fps)};
+    const auto NOW{std::chrono::steady_clock::now()};
+    auto phase{m_startEpoch + std::chrono::microseconds(m_startOffset)};
+    if ((phase < NOW) && (0 < PERIOD)) {
+        const int64_t ELAPSED{std::chrono::duration_cast<std::chrono::microseconds>(NOW - phase).count()};
+        phase += std::chrono::microseconds(((ELAPSED + PERIOD - 1) / PERIOD) * PERIOD);
+    }
+    std::this_thread::sleep_until(phase);
+}
+
+bool CameraPipeline::open(Spinnaker::CameraPtr camera) noexcept {
+    const uint32_t WIDTH{m_configuration.width};
+    const uint32_t HEIGHT{m_configuration.height};
+
+    m_sharedMemoryI420.reset(new SharedMemoryArea{m_configuration.nameI420, WIDTH * HEIGHT * 3 / 2, WIDTH, HEIGHT, layout::fourcc('I', '4', '2', '0'), m_configuration.publishMode, m_configuration.ringSlots});
+    if (!m_sharedMemoryI420 || !m_sharedMemoryI420->valid()) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << m_configuration.nameI420 << "'." << std::endl;
+        return false;
+    }
+
+    m_sharedMemoryARGB.reset(new SharedMemoryArea{m_configuration.nameARGB, WIDTH * HEIGHT * 4, WIDTH, HEIGHT, layout::fourcc('A', 'R', 'G', 'B'), m_configuration.publishMode, m_configuration.ringSlots});
+    if (!m_sharedMemoryARGB || !m_sharedMemoryARGB->valid()) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << m_configuration.nameARGB << "'." << std::endl;
+        return false;
+    }
+    std::clog << "[opendlv-device-camera-spinnaker]: Data from camera '" << m_configuration.serialNumber << "' available in I420 format in shared memory '" << m_sharedMemoryI420->name() << "' (" << m_sharedMemoryI420->size() << ") and in ARGB format in shared memory '" << m_sharedMemoryARGB->name() << "' (" << m_sharedMemoryARGB->size() << ")." << std::endl;
+
+    if (!initialize(camera)) {
+        return false;
+    }
+
+    // Accessing the low-level X11 data display.
+    if (m_configuration.verbose) {
+        m_display = XOpenDisplay(NULL);
+        Visual *visual{DefaultVisual(m_display, 0)};
+        m_window = XCreateSimpleWindow(m_display, RootWindow(m_display, 0), 0, 0, WIDTH, HEIGHT, 1, 0, 0);
+        // The image data is pointed to the ARGB frame before each update.
+        m_ximage = XCreateImage(m_display, visual, 24, ZPixmap, 0, nullptr, WIDTH, HEIGHT, 32, 0);
+        XMapWindow(m_display, m_window);
+    }
+
+    // Frames are converted in stripes on the shared pool of threads.
+    m_frameConverter.reset(new FrameConverter{WIDTH, HEIGHT, m_cameraPixelFormat, m_bayerPattern, m_configuration.demosaic, m_configuration.toneMap, m_configuration.pyramidLevels, m_configuration.crops, m_configuration.tensor, m_configuration.calibration, m_workerPool});
+
+    // HDR-aware consumers read the full bit depth before tone mapping.
+    if (!m_configuration.nameHDR.empty()) {
+        if (!m_frameConverter->isHighBitDepth()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Shared memory '" << m_configuration.nameHDR << "' requires a pixel format of more than 8 bits; it is not created." << std::endl;
+        } else {
+            m_sharedMemoryHDR.reset(new SharedMemoryArea{m_configuration.nameHDR, WIDTH * HEIGHT * 2, WIDTH, HEIGHT, m_hdrFourcc, m_configuration.publishMode, m_configuration.ringSlots});
+            if (!m_sharedMemoryHDR->valid()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << m_configuration.nameHDR << "'." << std::endl;
+                return false;
+            }
+            std::clog << "[opendlv-device-camera-spinnaker]: Data from camera '" << m_configuration.serialNumber << "' available in 16-bit format in shared memory '" << m_sharedMemoryHDR->name() << "' (" << m_sharedMemoryHDR->size() << ")." << std::endl;
+        }
+    }
+
+    // Each pyramid level is published like the full resolution frames.
+    m_sharedMemoryPyramidI420.clear();
+    m_sharedMemoryPyramidARGB.clear();
+    if (m_frameConverter->pyramidLevels() < m_configuration.pyramidLevels) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Only " << m_frameConverter->pyramidLevels() << " pyramid levels fit a frame of " << WIDTH << "x" << HEIGHT << "; a level needs a width and a height of the level above that are multiples of 4." << std::endl;
+    }
+    for (uint32_t level{1}; level <= m_frameConverter->pyramidLevels(); level++) {
+        const auto SIZE{m_frameConverter->pyramidSize(level)};
+        const std::string SUFFIX{"." + std::to_string(level)};
+        m_sharedMemoryPyramidI420.emplace_back(new SharedMemoryArea{m_configuration.nameI420 + SUFFIX, SIZE.first * SIZE.second * 3 / 2, SIZE.first, SIZE.second, layout::fourcc('I', '4', '2', '0'), m_configuration.publishMode, m_configuration.ringSlots});
+        if (!m_configuration.skipARGB) {
+            m_sharedMemoryPyramidARGB.emplace_back(new SharedMemoryArea{m_configuration.nameARGB + SUFFIX, SIZE.first * SIZE.second * 4, SIZE.first, SIZE.second, layout::fourcc('A', 'R', 'G', 'B'), m_configuration.publishMode, m_configuration.ringSlots});
+        }
+        for (const auto &area : {m_sharedMemoryPyramidI420.back().get(), m_sharedMemoryPyramidARGB.empty() ? nullptr : m_sharedMemoryPyramidARGB.back().get()}) {
+            if ((nullptr != area) && !area->valid()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << area->name() << "'." << std::endl;
+                return false;
+            }
+        }
+        std::clog << "[opendlv-device-camera-spinnaker]: Pyramid level " << level << " (" << SIZE.first << "x" << SIZE.second << ") of camera '" << m_configuration.serialNumber << "' available in shared memory '" << m_sharedMemoryPyramidI420.back()->name() << "'" << (m_sharedMemoryPyramidARGB.empty() ? std::string{} : " and '" + m_sharedMemoryPyramidARGB.back()->name() + "'") << "." << std::endl;
+    }
+
+    // Crops are taken from the I420 and ARGB rows during the conversion.
+    m_sharedMemoryCropI420.clear();
+    m_sharedMemoryCropARGB.clear();
+    if (m_frameConverter->crops().size() < m_configuration.crops.size()) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Only " << m_frameConverter->crops().size() << " crops lie within a frame of " << WIDTH << "x" << HEIGHT << " (at most " << FrameConverter::MAX_CROPS << ")." << std::endl;
+    }
+    for (uint32_t i{0}; i < m_frameConverter->crops().size(); i++) {
+        const FrameConverter::Crop &crop{m_frameConverter->crops()[i]};
+        const uint32_t OW{crop.outputWidth};
+        const uint32_t OH{crop.outputHeight};
+        const std::string SUFFIX{"." + ((i < m_configuration.cropNames.size()) ? m_configuration.cropNames[i] : "crop" + std::to_string(i))};
+        m_sharedMemoryCropI420.emplace_back(new SharedMemoryArea{m_configuration.nameI420 + SUFFIX, OW * OH * 3 / 2, OW, OH, layout::fourcc('I', '4', '2', '0'), m_configuration.publishMode, m_configuration.ringSlots});
+        if (!m_configuration.skipARGB) {
+            m_sharedMemoryCropARGB.emplace_back(new SharedMemoryArea{m_configuration.nameARGB + SUFFIX, OW * OH * 4, OW, OH, layout::fourcc('A', 'R', 'G', 'B'), m_configuration.publishMode, m_configuration.ringSlots});
+        }
+        for (const auto &area : {m_sharedMemoryCropI420.back().get(), m_sharedMemoryCropARGB.empty() ? nullptr : m_sharedMemoryCropARGB.back().get()}) {
+            if ((nullptr != area) && !area->valid()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << area->name() << "'." << std::endl;
+                return false;
+            }
+        }
+        std::clog << "[opendlv-device-camera-spinnaker]: Crop " << crop.width << "x" << crop.height << "+" << crop.x << "+" << crop.y << " (" << OW << "x" << OH << ") of camera '" << m_configuration.serialNumber << "' available in shared memory '" << m_sharedMemoryCropI420.back()->name() << "'" << (m_sharedMemoryCropARGB.empty() ? std::string{} : " and '" + m_sharedMemoryCropARGB.back()->name() + "'") << "." << std::endl;
+    }
+
+    // The tensor is resampled from the ARGB frame after the conversion.
+    m_sharedMemoryTensor.reset();
+    if (0 < m_frameConverter->tensorSize()) {
+        const FrameConverter::Tensor &tensor{m_frameConverter->tensor()};
+        const char TYPE{(kernels::TensorType::FLOAT32 == tensor.type) ? 'f' : ((kernels::TensorType::FLOAT16 == tensor.type) ? 'h' : 'b')};
+        m_sharedMemoryTensor.reset(new SharedMemoryArea{m_configuration.nameTensor, m_frameConverter->tensorSize(), tensor.width, tensor.height, layout::fourcc('C', 'H', 'W', TYPE), m_configuration.publishMode, m_configuration.ringSlots});
+        if (!m_sharedMemoryTensor->valid()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << m_configuration.nameTensor << "'." << std::endl;
+            return false;
+        }
+        std::clog << "[opendlv-device-camera-spinnaker]: Tensor 3x" << tensor.height << "x" << tensor.width << " of camera '" << m_configuration.serialNumber << "' available in shared memory '" << m_sharedMemoryTensor->name() << "' (" << m_sharedMemoryTensor->size() << ")." << std::endl;
+    }
+
+    // Undistorted frames are interpolated from the complete I420 and ARGB frames.
+    m_sharedMemoryUndistortedI420.reset();
+    m_sharedMemoryUndistortedARGB.reset();
+    if (m_configuration.calibration.valid()) {
+        const std::string SUFFIX{".undistorted"};
+        if (!m_frameConverter->canUndistort()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: A frame of " << WIDTH << "x" << HEIGHT << " is too small to be undistorted." << std::endl;
+        } else {
+            m_sharedMemoryUndistortedI420.reset(new SharedMemoryArea{m_configuration.nameI420 + SUFFIX, WIDTH * HEIGHT * 3 / 2, WIDTH, HEIGHT, layout::fourcc('I', '4', '2', '0'), m_configuration.publishMode, m_configuration.ringSlots});
+            if (!m_configuration.skipARGB) {
+                m_sharedMemoryUndistortedARGB.reset(new SharedMemoryArea{m_configuration.nameARGB + SUFFIX, WIDTH * HEIGHT * 4, WIDTH, HEIGHT, layout::fourcc('A', 'R', 'G', 'B'), m_configuration.publishMode, m_configuration.ringSlots});
+            }
+            for (const auto &area : {m_sharedMemoryUndistortedI420.get(), m_sharedMemoryUndistortedARGB.get()}) {
+                if ((nullptr != area) && !area->valid()) {
+                    std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << area->name() << "'." << std::endl;
+                    return false;
+                }
+            }
+            std::clog << "[opendlv-device-camera-spinnaker]: Undistorted frames of camera '" << m_configuration.serialNumber << "' available in shared memory '" << m_sharedMemoryUndistortedI420->name() << "'" << (m_sharedMemoryUndistortedARGB ? " and '" + m_sharedMemoryUndistortedARGB->name() + "'" : std::string{}) << "." << std::endl;
+        }
+    }
+
+    // Further formats are derived from the I420 or ARGB frames during the conversion.
+    m_sharedMemoryOutputs.clear();
+    for (const auto &output : m_configuration.outputs) {
+        if ((OutputFormat::UYVY == output.format) && (FrameConverter::PixelFormat::UYVY != m_cameraPixelFormat)) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Shared memory '" << output.name << "' requires the pixel format yuv422; it is not created." << std::endl;
+            m_sharedMemoryOutputs.emplace_back(nullptr);
+            continue;
+        }
+        const auto SIZE_AND_FOURCC{frameSizeAndFourcc(output.format, WIDTH, HEIGHT)};
+        m_sharedMemoryOutputs.emplace_back(new SharedMemoryArea{output.name, SIZE_AND_FOURCC.first, WIDTH, HEIGHT, SIZE_AND_FOURCC.second, m_configuration.publishMode, m_configuration.ringSlots});
+        if (!m_sharedMemoryOutputs.back()->valid()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << output.name << "'." << std::endl;
+            return false;
+        }
+        std::clog << "[opendlv-device-camera-spinnaker]: Data from camera '" << m_configuration.serialNumber << "' available in shared memory '" << m_sharedMemoryOutputs.back()->name() << "' (" << m_sharedMemoryOutputs.back()->size() << ")." << std::endl;
+    }
+
+    // Frames are handed from the acquisition thread to the conversion thread;
+    // any discarded frame must be returned to the camera's buffer pool.
+    m_frameQueue.reset(new FrameQueue<Frame>{m_configuration.queueSize, m_configuration.queueDropPolicy, [](Frame &frame) { releaseFrame(frame); }});
+    return true;
+}
+
+bool CameraPipeline::initialize(Spinnaker::CameraPtr camera) noexcept {
+    const uint32_t WIDTH{m_configuration.width};
+    const uint32_t HEIGHT{m_configuration.height};
+
+    try {
+        m_camera = camera;
+        m_camera->Init();
+
+        Spinnaker::GenApi::INodeMap &cameraNodeMap{m_camera->GetTLDeviceNodeMap()};
+        {
+            Spinnaker::GenApi::FeatureList_t features;
+            Spinnaker::GenApi::CCategoryPtr category{cameraNodeMap.GetNode("DeviceInformation")};
+            if (Spinnaker::GenApi::IsAvailable(category) && Spinnaker::GenApi::IsReadable(category)) {
+                category->GetFeatures(features);
+                for (auto it = features.begin(); it != features.end(); it++) {
+                    Spinnaker::GenApi::CNodePtr featureNode{*it};
+                    std::clog << "  " << featureNode->GetName() << ": ";
+                    Spinnaker::GenApi::CValuePtr valuePtr = (Spinnaker::GenApi::CValuePtr)featureNode;
+                    std::clog << (Spinnaker::GenApi::IsReadable(valuePtr) ? valuePtr->ToString() : "Node not readable");
+                    std::clog << std::endl;
+                }
+            } else {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Could not read device control information." << std::endl;
+            }
+        }
+
+        // Disable trigger mode; it is switched on again for slaves once configured.
+        {
+            if (Spinnaker::GenApi::RW != m_camera->TriggerMode.GetAccessMode()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Could not disable trigger mode." << std::endl;
+                return false;
+            }
+            m_camera->TriggerMode.SetValue(Spinnaker::TriggerModeEnums::TriggerMode_Off);
+        }
+
+        Spinnaker::GenApi::INodeMap &nodeMap              = m_camera->GetNodeMap();
+        if (!configureTrigger(nodeMap)) {
+            return false;
+        }
+        if (!configurePixelFormat(nodeMap)) {
+            return false;
+        }
+
+        // Disable auto frame rate; a slave's frame rate is given by its trigger.
+        try {
+            Spinnaker::GenApi::CBooleanPtr acquisitionFrameRateEnable = nodeMap.GetNode("AcquisitionFrameRateEnable");
+            if (IsAvailable(acquisitionFrameRateEnable) && IsReadable(acquisitionFrameRateEnable)) {
+                const bool FREE_RUNNING{Trigger::SLAVE != m_configuration.trigger};
+                acquisitionFrameRateEnable->SetValue(FREE_RUNNING);
+                if (FREE_RUNNING) {
+                    m_camera->AcquisitionFrameRate.SetValue(m_configuration.fps);
+                }
+            } else {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Could not disable frame rate." << std::endl;
+            }
+        }
+        catch (...) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Could not set frame rate." << std::endl;
+        }
+
+        // Enable auto exposure.
+        m_camera->ExposureAuto.SetValue(Spinnaker::ExposureAutoEnums::ExposureAuto_Continuous);
+
+        // Enable auto gain.
+        m_camera->GainAuto.SetValue(Spinnaker::GainAutoEnums::GainAuto_Continuous);
+
+        // Enable auto white balance.
+        if ((PixelFormat::YUV422 == m_configuration.pixelFormat) || (PixelFormat::BAYER8 == m_configuration.pixelFormat) || (PixelFormat::BAYER12P == m_configuration.pixelFormat)) {
+            m_camera->BalanceWhiteAuto.SetValue(Spinnaker::BalanceWhiteAutoEnums::BalanceWhiteAuto_Continuous);
+        }
+
+        // Enable PTP.
+        try {
+            m_camera->GevIEEE1588.SetValue(true);
+        }
+        catch (...) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Could not enable PTP." << std::endl;
+        }
+
+        configureTransport(nodeMap);
+
+        // Define WIDTH, HEIGHT, OFFSETX, OFFSETY.
+        m_camera->Height.SetValue(HEIGHT);
+        m_camera->Width.SetValue(WIDTH);
+        m_camera->OffsetX.SetValue(m_configuration.offsetX);
+        m_camera->OffsetY.SetValue(m_configuration.offsetY);
+
+        // Let the camera append its exposure and gain to every frame; this
+        // changes the payload size and must hence precede the buffer setup.
+        if (!m_configuration.noChunkData) {
+            m_withChunkData = enableChunkData(nodeMap);
+            if (!m_withChunkData) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Could not enable chunk data; exposure time and gain will not be available per frame." << std::endl;
+            }
+        }
+
+        // Let the camera write its frames directly into shared memory. The
+        // queued frames plus the published one must not starve the stream.
+        if (!m_configuration.nameNative.empty()) {
+            const uint32_t BUFFERS{std::max(m_configuration.nativeBuffers, m_configuration.queueSize + 3)};
+            const uint32_t PAYLOAD_SIZE{static_cast<uint32_t>(m_camera->PayloadSize.GetValue())};
+            if (!m_userBufferPool) {
+                m_userBufferPool.reset(new UserBufferPool{m_configuration.nameNative, BUFFERS, PAYLOAD_SIZE, WIDTH, HEIGHT, m_cameraFourcc});
+            }
+            if (!m_userBufferPool->valid()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << m_configuration.nameNative << "'." << std::endl;
+                return false;
+            }
+            m_userBufferPool->attach(m_camera);
+            std::clog << "[opendlv-device-camera-spinnaker]: Data from camera '" << m_configuration.serialNumber << "' available in native format in shared memory '" << m_userBufferPool->name() << "' (" << m_userBufferPool->size() << ")." << std::endl;
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Failed to configure camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CameraPipeline::configurePixelFormat(Spinnaker::GenApi::INodeMap &nodeMap) noexcept {
+    struct Candidate {
+        const char *entry;
+        FrameConverter::PixelFormat pixelFormat;
+        kernels::BayerPattern bayerPattern;
+        uint32_t fourcc;
+        uint32_t hdrFourcc;
+    };
+    using FP = FrameConverter::PixelFormat;
+    using BP = kernels::BayerPattern;
+    // Bayer frames are requested in whichever arrangement the sensor has.
+    std::vector<Candidate> candidates;
+    switch (m_configuration.pixelFormat) {
+        case PixelFormat::MONO8:
+            candidates = {{"Mono8", FP::MONO8, BP::RGGB, layout::fourcc('G', 'R', 'E', 'Y'), 0}};
+            break;
+        case PixelFormat::MONO12P:
+            candidates = {{"Mono12p", FP::MONO12P, BP::RGGB, layout::fourcc('Y', '1', '2', 'p'), layout::fourcc('Y', '1', '6', ' ')}};
+            break;
+        case PixelFormat::MONO16:
+            candidates = {{"Mono16", FP::MONO16, BP::RGGB, layout::fourcc('Y', '1', '6', ' '), layout::fourcc('Y', '1', '6', ' ')}};
+            break;
+        case PixelFormat::BAYER8:
+            candidates = {{"BayerRG8", FP::BAYER8, BP::RGGB, layout::fourcc('R', 'G', 'G', 'B'), 0},
+                          {"BayerGR8", FP::BAYER8, BP::GRBG, layout::fourcc('G', 'R', 'B', 'G'), 0},
+                          {"BayerGB8", FP::BAYER8, BP::GBRG, layout::fourcc('G', 'B', 'R', 'G'), 0},
+                          {"BayerBG8", FP::BAYER8, BP::BGGR, layout::fourcc('B', 'A', '8', '1'), 0}};
+            break;
+        case PixelFormat::BAYER12P:
+            candidates = {{"BayerRG12p", FP::BAYER12P, BP::RGGB, layout::fourcc('R', 'G', '1', 'p'), layout::fourcc('R', 'G', '1', '6')},
+                          {"BayerGR12p", FP::BAYER12P, BP::GRBG, layout::fourcc('G', 'R', '1', 'p'), layout::fourcc('G', 'R', '1', '6')},
+                          {"BayerGB12p", FP::BAYER12P, BP::GBRG, layout::fourcc('G', 'B', '1', 'p'), layout::fourcc('G', 'B', '1', '6')},
+                          {"BayerBG12p", FP::BAYER12P, BP::BGGR, layout::fourcc('B', 'G', '1', 'p'), layout::fourcc('B', 'Y', 'R', '2')}};
+            break;
+        default:
+            candidates = {{"YUV422Packed", FP::UYVY, BP::RGGB, layout::fourcc('U', 'Y', 'V', 'Y'), 0}};
+            break;
+    }
+    m_cameraPixelFormat = candidates.front().pixelFormat;
+    m_bayerPattern      = candidates.front().bayerPattern;
+    m_cameraFourcc      = candidates.front().fourcc;
+    m_hdrFourcc         = candidates.front().hdrFourcc;
+
+    // The frames cannot be converted in any other than the requested layout.
+    const bool REQUIRED{(PixelFormat::YUV422 != m_configuration.pixelFormat) && (PixelFormat::MONO8 != m_configuration.pixelFormat)};
+    try {
+        Spinnaker::GenApi::CEnumerationPtr ptrPixelFormat = nodeMap.GetNode("PixelFormat");
+        if (!IsAvailable(ptrPixelFormat) || !IsWritable(ptrPixelFormat)) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Error: Pixel format not available." << std::endl;
+            return !REQUIRED;
+        }
+        for (const auto &candidate : candidates) {
+            Spinnaker::GenApi::CEnumEntryPtr entry = ptrPixelFormat->GetEntryByName(candidate.entry);
+            if (IsAvailable(entry) && IsReadable(entry)) {
+                ptrPixelFormat->SetIntValue(entry->GetValue());
+                m_cameraPixelFormat = candidate.pixelFormat;
+                m_bayerPattern      = candidate.bayerPattern;
+                m_cameraFourcc      = candidate.fourcc;
+                m_hdrFourcc         = candidate.hdrFourcc;
+                std::clog << "[opendlv-device-camera-spinnaker]: Pixel format set to " << ptrPixelFormat->GetCurrentEntry()->GetSymbolic() << "." << std::endl;
+                return true;
+            }
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not set the pixel format of camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+        return !REQUIRED;
+    }
+    std::cerr << "[opendlv-device-camera-spinnaker]: Error: Pixel format " << candidates.front().entry << ((1 < candidates.size()) ? " or a similar Bayer arrangement" : "") << " not available." << std::endl;
+    return !REQUIRED;
+}
+
+bool CameraPipeline::configureTrigger(Spinnaker::GenApi::INodeMap &nodeMap) noexcept {
+    bool retVal{true};
+    if (Trigger::MASTER == m_configuration.trigger) {
+        // The master signals the start of each exposure to the slaves.
+        retVal = setEnumeration(nodeMap, "LineSelector", m_configuration.triggerOutput)
+              && setEnumeration(nodeMap, "LineMode", "Output")
+              && setEnumeration(nodeMap, "LineSource", "ExposureActive");
+        if (retVal) {
+            std::clog << "[opendlv-device-camera-spinnaker]: Camera '" << m_configuration.serialNumber << "' triggers on " << m_configuration.triggerOutput << "." << std::endl;
+        }
+    } else if (Trigger::SLAVE == m_configuration.trigger) {
+        retVal = setEnumeration(nodeMap, "TriggerSelector", "FrameStart")
+              && setEnumeration(nodeMap, "TriggerSource", m_configuration.triggerInput)
+              && setEnumeration(nodeMap, "TriggerActivation", "RisingEdge");
+        // Accept the next trigger while the previous frame is read out.
+        setEnumeration(nodeMap, "TriggerOverlap", "ReadOut");
+        retVal = retVal && setEnumeration(nodeMap, "TriggerMode", "On");
+        if (retVal) {
+            std::clog << "[opendlv-device-camera-spinnaker]: Camera '" << m_configuration.serialNumber << "' is triggered on " << m_configuration.triggerInput << "." << std::endl;
+        }
+    }
+    if (!retVal) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not configure trigger of camera '" << m_configuration.serialNumber << "'." << std::endl;
+    }
+    return retVal;
+}
+
+void CameraPipeline::configureTransport(Spinnaker::GenApi::INodeMap &nodeMap) noexcept {
+    try {
+        Spinnaker::GenApi::CIntegerPtr packetSize = nodeMap.GetNode("GevSCPSPacketSize");
+        if (IsAvailable(packetSize) && IsWritable(packetSize)) {
+            int64_t size{m_configuration.packetSize};
+            if (m_configuration.autoPacketSize) {
+                // Probes the path with test packets of decreasing size.
+                size = static_cast<int64_t>(m_camera->DiscoverMaxPacketSize());
+            }
+            if (0 < size) {
+                size = std::min(std::max(size, packetSize->GetMin()), packetSize->GetMax());
+                size -= (size - packetSize->GetMin()) % std::max<int64_t>(packetSize->GetInc(), 1);
+                packetSize->SetValue(size);
+            }
+            std::clog << "[opendlv-device-camera-spinnaker]: Packet size of camera '" << m_configuration.serialNumber << "' is " << packetSize->GetValue() << " bytes." << std::endl;
+        } else if ((0 < m_configuration.packetSize) || m_configuration.autoPacketSize) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Packet size of camera '" << m_configuration.serialNumber << "' cannot be set." << std::endl;
+        }
+
+        Spinnaker::GenApi::CIntegerPtr packetDelay = nodeMap.GetNode("GevSCPD");
+        if (IsAvailable(packetDelay) && IsWritable(packetDelay)) {
+            // A reconnected camera continues with the tuned delay.
+            int64_t delay{(0 <= m_packetDelay) ? m_packetDelay : m_configuration.packetDelay};
+            if (0 <= delay) {
+                packetDelay->SetValue(std::min(std::max(delay, packetDelay->GetMin()), packetDelay->GetMax()));
+            }
+            m_packetDelay = packetDelay->GetValue();
+            std::clog << "[opendlv-device-camera-spinnaker]: Inter-packet delay of camera '" << m_configuration.serialNumber << "' is " << m_packetDelay << " ticks." << std::endl;
+        } else if ((0 <= m_configuration.packetDelay) || m_configuration.autoPacketDelay) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Inter-packet delay of camera '" << m_configuration.serialNumber << "' cannot be set." << std::endl;
+        }
+
+        // A reconnected camera keeps its share of the link.
+        Spinnaker::GenApi::CIntegerPtr throughputLimit = nodeMap.GetNode("DeviceLinkThroughputLimit");
+        if ((0 < m_throughputLimit) && IsAvailable(throughputLimit) && IsWritable(throughputLimit)) {
+            throughputLimit->SetValue(std::min(std::max(m_throughputLimit, throughputLimit->GetMin()), throughputLimit->GetMax()));
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not configure the transport of camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+    }
+}
+
+// Increases the inter-packet delay by half after a period with lost packets
+// and reduces it by a tenth after ten periods without, but never below the
+// delay that limits the camera's throughput.
+void CameraPipeline::tunePacketDelay(const StreamStatistics::Report &report) noexcept {
+    const uint32_t PERIODS_BEFORE_DECREASE{10};
+    if (!m_configuration.autoPacketDelay || !m_camera.IsValid() || (0 > m_packetDelay)) {
+        return;
+    }
+    try {
+        Spinnaker::GenApi::CIntegerPtr packetDelay = m_camera->GetNodeMap().GetNode("GevSCPD");
+        if (!IsAvailable(packetDelay) || !IsWritable(packetDelay)) {
+            return;
+        }
+        const int64_t STEP{std::max<int64_t>(packetDelay->GetInc(), (packetDelay->GetMax() - packetDelay->GetMin()) / 1000)};
+        int64_t delay{m_packetDelay};
+        if (0 < report.lostPackets + report.resendRequests) {
+            m_periodsWithoutLoss = 0;
+            delay += std::max(STEP, delay / 2);
+        } else if (PERIODS_BEFORE_DECREASE <= ++m_periodsWithoutLoss) {
+            m_periodsWithoutLoss = 0;
+            delay -= std::max(STEP, delay / 10);
+        }
+        delay = std::min(std::max(std::max(delay, m_minimumPacketDelay), packetDelay->GetMin()), packetDelay->GetMax());
+        if (delay != m_packetDelay) {
+            packetDelay->SetValue(delay);
+            m_packetDelay = packetDelay->GetValue();
+            if (m_configuration.debug) {
+                std::clog << "[opendlv-device-camera-spinnaker]: Inter-packet delay of camera '" << m_configuration.serialNumber << "' set to " << m_packetDelay << " ticks." << std::endl;
+            }
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        // Delay cannot be changed while streaming on this camera.
+        m_packetDelay = -1;
+    }
+}
+
+void CameraPipeline::start() {
+    m_running.store(true);
+    startStreaming();
+    m_conversion = std::thread(&CameraPipeline::convert, this);
+    m_supervision = std::thread(&CameraPipeline::supervise, this);
+}
+
+void CameraPipeline::stop() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_supervisionMutex);
+        m_running.store(false);
+    }
+    m_supervisionCondition.notify_all();
+    if (m_supervision.joinable()) {
+        m_supervision.join();
+    }
+    if (m_conversion.joinable()) {
+        m_conversion.join();
+    }
+    std::lock_guard<std::mutex> lck(m_cameraMutex);
+    stopStreaming();
+    deinitialize();
+}
+
+void CameraPipeline::onDeviceArrival() noexcept {
+    // Retry the recovery right away instead of waiting for the next attempt.
+    m_supervisionCondition.notify_all();
+}
+
+void CameraPipeline::onDeviceRemoval() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_supervisionMutex);
+        m_deviceLost.store(true);
+    }
+    m_supervisionCondition.notify_all();
+}
+
+void CameraPipeline::startStreaming() {
+    // Frames are either pushed by the transport layer or polled from a dedicated thread.
+    if (m_configuration.eventAcquisition) {
+        m_frameEventHandler.reset(new FrameEventHandler{*m_frameQueue, m_streamStatistics, m_withChunkData, m_configuration.debug, m_streamGeneration.load(), m_configuration.queueSize + 2});
+        m_camera->RegisterEventHandler(*m_frameEventHandler);
+    }
+
+    // Start camera.
+    m_camera->AcquisitionMode.SetValue(Spinnaker::AcquisitionModeEnums::AcquisitionMode_Continuous);
+    waitForStartPhase();
+    m_camera->BeginAcquisition();
+    m_acquiring = true;
+
+    if (!m_configuration.eventAcquisition) {
+        m_acquisition = std::thread(&CameraPipeline::acquire, this);
+    }
+}
+
+void CameraPipeline::stopStreaming() noexcept {
+    // A frame that the conversion thread dequeued before it took the camera
+    // mutex must not be used once the stream's buffers are gone.
+    m_streamGeneration++;
+    if (m_acquisition.joinable()) {
+        m_acquisition.join();
+    }
+    if (m_userBufferPool) {
+        m_userBufferPool->release();
+    }
+    try {
+        if (m_acquiring) {
+            m_acquiring = false;
+            m_camera->EndAcquisition();
+        }
+        if (m_frameEventHandler) {
+            m_camera->UnregisterEventHandler(*m_frameEventHandler);
+        }
+    }
+    catch (Spinnaker::Exception &e) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Failed to stop camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+    }
+    if (m_frameQueue) {
+        Frame frame;
+        while (m_frameQueue->tryPop(frame)) {
+            releaseFrame(frame);
+        }
+    }
+    // Queued frames refer to the handler's images until they are released.
+    m_frameEventHandler.reset();
+}
+
+void CameraPipeline::deinitialize() noexcept {
+    if (m_camera.IsValid()) {
+        try {
+            m_camera->DeInit();
+        }
+        catch (...) {
+            // Camera is already gone.
+        }
+        m_camera = nullptr;
+    }
+}
+
+// Supervision thread: re-initializes the camera after it was lost while
+// the shared memory areas stay in place for the consumers.
+void CameraPipeline::supervise() noexcept {
+    const auto RETRY_INTERVAL{std::chrono::seconds(1)};
+    while (m_running.load()) {
+        {
+            std::unique_lock<std::mutex> lck(m_supervisionMutex);
+            m_supervisionCondition.wait_for(lck, RETRY_INTERVAL, [this]() { return !m_running.load() || m_deviceLost.load(); });
+            if (!m_running.load() || !m_deviceLost.load()) {
+                continue;
+            }
+        }
+
+        const int64_t LOST_SINCE{cluon::time::toMicroseconds(cluon::time::now())};
+        std::cerr << "[opendlv-device-camera-spinnaker]: Lost camera '" << m_configuration.serialNumber << "'; trying to reconnect." << std::endl;
+        {
+            std::lock_guard<std::mutex> lck(m_cameraMutex);
+            stopStreaming();
+            deinitialize();
+        }
+
+        while (m_running.load()) {
+            Spinnaker::CameraPtr camera{m_findCamera ? m_findCamera(m_configuration.serialNumber) : Spinnaker::CameraPtr{nullptr}};
+            if (camera.IsValid()) {
+                std::lock_guard<std::mutex> lck(m_cameraMutex);
+                if (initialize(camera)) {
+                    try {
+                        m_deviceLost.store(false);
+                        // The restarted camera counts its frame IDs from 0 again.
+                        if (nullptr != m_frameSetArea) {
+                            m_frameSetArea->resetCamera(m_configuration.index);
+                        }
+                        startStreaming();
+                        m_recoveries++;
+                        m_lostSince.store(LOST_SINCE);
+                        break;
+                    }
+                    catch (Spinnaker::Exception &e) {
+                        std::cerr << "[opendlv-device-camera-spinnaker]: Failed to restart camera '" << m_configuration.serialNumber << "': " << e.what() << std::endl;
+                        m_deviceLost.store(true);
+                        stopStreaming();
+                    }
+                }
+                deinitialize();
+            }
+            std::unique_lock<std::mutex> lck(m_supervisionMutex);
+            m_supervisionCondition.wait_for(lck, RETRY_INTERVAL, [this]() { return !m_running.load(); });
+        }
+    }
+}
+
+// Acquisition thread: grab frames as fast as the camera delivers them.
+void CameraPipeline::acquire() noexcept {
+    // Timeouts are expected for triggered cameras; other errors in a row
+    // indicate that the camera is gone.
+    const uint64_t GRAB_TIMEOUT_MS{1000};
+    const uint32_t MAX_ERRORS{3};
+    uint32_t errors{0};
+    const uint64_t GENERATION{m_streamGeneration.load()};
+    while (m_running.load() && !m_deviceLost.load() && !cluon::TerminateHandler::instance().isTerminated.load()) {
+        try {
+            Spinnaker::ImagePtr image{m_camera->GetNextImage(GRAB_TIMEOUT_MS)};
+            errors = 0;
+            if (m_streamStatistics.countFrame(image)) {
+                Frame frame;
+                frame.image          = image;
+                frame.isCameraBuffer = true;
+                frame.generation     = GENERATION;
+                describeFrame(frame, image, m_withChunkData);
+                if (!m_frameQueue->push(std::move(frame)) && m_configuration.debug) {
+                    std::clog << "[opendlv-device-camera-spinnaker]: Frame queue of camera '" << m_configuration.serialNumber << "' full, " << m_frameQueue->dropped() << " frames dropped so far." << std::endl;
+                }
+            } else {
+                image->Release();
+            }
+        }
+        catch (Spinnaker::Exception &e) {
+            // No frame within timeout; check for termination again.
+            if ((Spinnaker::SPINNAKER_ERR_TIMEOUT != e.GetError()) && (MAX_ERRORS <= ++errors)) {
+                onDeviceRemoval();
+            }
+        }
+    }
+}
+
+// Frame conversion loop; the timeout lets us notice termination even if the
+// camera stopped streaming.
+void CameraPipeline::convert() noexcept {
+    m_workerPool.pinCaller();
+    const uint32_t WIDTH{m_configuration.width};
+    const uint32_t HEIGHT{m_configuration.height};
+    const bool WITH_ARGB{!m_configuration.skipARGB || m_configuration.verbose};
+    // Without a reader timeout, all outputs are produced for every frame.
+    const int64_t READER_TIMEOUT{static_cast<int64_t>(m_configuration.readerTimeout) * 1000};
+    bool i420Demanded{true};
+    bool argbDemanded{true};
+    bool hdrDemanded{true};
+    bool tensorDemanded{true};
+    bool undistortedI420Demanded{true};
+    bool undistortedARGBDemanded{true};
+    // Unlike std::vector<bool>, a deque hands out references to its flags.
+    std::deque<bool> outputDemanded(m_sharedMemoryOutputs.size(), true);
+    // The pyramid is built as a whole if any of its levels is read.
+    std::deque<bool> pyramidDemanded(m_sharedMemoryPyramidI420.size() + m_sharedMemoryPyramidARGB.size(), true);
+    std::deque<bool> cropI420Demanded(m_sharedMemoryCropI420.size(), true);
+    std::deque<bool> cropARGBDemanded(m_sharedMemoryCropARGB.size(), true);
+
+    {
+        std::lock_guard<std::mutex> lck(m_cameraMutex);
+        m_streamStatistics.sample(m_camera.IsValid() ? &m_camera->GetTLStreamNodeMap() : nullptr, m_frameQueue->dropped());
+    }
+    // The inter-packet delay is tuned once per second unless statistics are reported anyway.
+    const uint32_t STATISTICS_PERIOD{((0 == m_configuration.statisticsPeriod) && m_configuration.autoPacketDelay) ? 1 : m_configuration.statisticsPeriod};
+    auto lastStatistics{std::chrono::steady_clock::now()};
+    bool firstFrame{true};
+    while (m_running.load() && !cluon::TerminateHandler::instance().isTerminated.load()) {
+        if ((0 < STATISTICS_PERIOD) && (std::chrono::steady_clock::now() - lastStatistics >= std::chrono::seconds(STATISTICS_PERIOD))) {
+            lastStatistics = std::chrono::steady_clock::now();
+            reportStatistics();
+        }
+
+        Frame frame;
+        if (m_frameQueue->waitAndPop(frame, std::chrono::milliseconds(100))) {
+            // The camera must not be released while one of its frames is converted;
+            // frames dequeued before the stream was stopped are dropped unreleased.
+            std::lock_guard<std::mutex> lck(m_cameraMutex);
+            if (frame.generation != m_streamGeneration.load()) {
+                frame = Frame{};
+                continue;
+            }
+            Spinnaker::ImagePtr image{frame.image};
+            if (!image.IsValid()) {
+                continue;
+            }
+            layout::FrameMetadata metadata{frame.metadata};
+            uint64_t imageTimestamp = metadata.cameraTimestamp;
+            int width               = image->GetWidth();
+            int height              = image->GetHeight();
+
+            if (m_configuration.debug) {
+                std::clog << "Grabbed frame of size " << width << "x" << height << " at " << imageTimestamp << " from camera '" << m_configuration.serialNumber << "'" << std::endl;
+            }
+            cluon::data::TimeStamp ts{cluon::time::now()};
+            if (!m_configuration.noCameraTimestamp) {
+                ts = cluon::time::fromMicroseconds(imageTimestamp/1000);
+            }
+
+            if ((static_cast<uint32_t>(width) == WIDTH) && (static_cast<uint32_t>(height) == HEIGHT)) {
+                // Publishing the native frame only flips the index of the latest slot.
+                if (m_userBufferPool) {
+                    m_userBufferPool->publish(frame, ts);
+                }
+
+                // Outputs without an active reader are skipped; the frame set and the display always need theirs.
+                const bool WITH_I420_NOW{(0 == READER_TIMEOUT) || (nullptr != m_frameSetArea) || updateDemand(*m_sharedMemoryI420, READER_TIMEOUT, i420Demanded)};
+                const bool WITH_ARGB_NOW{WITH_ARGB && ((0 == READER_TIMEOUT) || m_configuration.verbose || updateDemand(*m_sharedMemoryARGB, READER_TIMEOUT, argbDemanded))};
+                const bool WITH_HDR_NOW{m_sharedMemoryHDR && ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryHDR, READER_TIMEOUT, hdrDemanded))};
+
+                FrameConverter::Destinations destinations;
+                destinations.i420 = WITH_I420_NOW ? m_sharedMemoryI420->beginWrite(ts) : nullptr;
+                destinations.argb = WITH_ARGB_NOW ? m_sharedMemoryARGB->beginWrite(ts) : nullptr;
+                destinations.wide = WITH_HDR_NOW ? reinterpret_cast<uint16_t *>(m_sharedMemoryHDR->beginWrite(ts)) : nullptr;
+                std::vector<SharedMemoryArea *> outputs;
+                for (uint32_t i{0}; i < m_sharedMemoryOutputs.size(); i++) {
+                    SharedMemoryArea *area{m_sharedMemoryOutputs[i].get()};
+                    if ((nullptr == area) || ((0 != READER_TIMEOUT) && !updateDemand(*area, READER_TIMEOUT, outputDemanded[i]))) {
+                        continue;
+                    }
+                    uint8_t *dst{area->beginWrite(ts)};
+                    switch (m_configuration.outputs[i].format) {
+                        case OutputFormat::NV12: destinations.nv12 = dst; break;
+                        case OutputFormat::BGR24: destinations.bgr24 = dst; break;
+                        case OutputFormat::RGB24: destinations.rgb24 = dst; break;
+                        case OutputFormat::RGB_PLANAR: destinations.rgbPlanar = dst; break;
+                        case OutputFormat::UYVY: destinations.uyvy = dst; break;
+                    }
+                    outputs.push_back(area);
+                }
+                for (uint32_t i{0}; i < m_sharedMemoryCropI420.size(); i++) {
+                    if ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryCropI420[i], READER_TIMEOUT, cropI420Demanded[i])) {
+                        destinations.cropI420[i] = m_sharedMemoryCropI420[i]->beginWrite(ts);
+                        outputs.push_back(m_sharedMemoryCropI420[i].get());
+                    }
+                }
+                for (uint32_t i{0}; i < m_sharedMemoryCropARGB.size(); i++) {
+                    if ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryCropARGB[i], READER_TIMEOUT, cropARGBDemanded[i])) {
+                        destinations.cropARGB[i] = m_sharedMemoryCropARGB[i]->beginWrite(ts);
+                        outputs.push_back(m_sharedMemoryCropARGB[i].get());
+                    }
+                }
+                if (m_sharedMemoryTensor && ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryTensor, READER_TIMEOUT, tensorDemanded))) {
+                    destinations.tensor = m_sharedMemoryTensor->beginWrite(ts);
+                    outputs.push_back(m_sharedMemoryTensor.get());
+                }
+                if (m_sharedMemoryUndistortedI420 && ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryUndistortedI420, READER_TIMEOUT, undistortedI420Demanded))) {
+                    destinations.undistortedI420 = m_sharedMemoryUndistortedI420->beginWrite(ts);
+                    outputs.push_back(m_sharedMemoryUndistortedI420.get());
+                }
+                if (m_sharedMemoryUndistortedARGB && ((0 == READER_TIMEOUT) || updateDemand(*m_sharedMemoryUndistortedARGB, READER_TIMEOUT, undistortedARGBDemanded))) {
+                    destinations.undistortedARGB = m_sharedMemoryUndistortedARGB->beginWrite(ts);
+                    outputs.push_back(m_sharedMemoryUndistortedARGB.get());
+                }
+                bool withPyramid{0 == READER_TIMEOUT};
+                for (uint32_t i{0}; (0 != READER_TIMEOUT) && (i < pyramidDemanded.size()); i++) {
+                    const SharedMemoryArea &area{(i < m_sharedMemoryPyramidI420.size()) ? *m_sharedMemoryPyramidI420[i] : *m_sharedMemoryPyramidARGB[i - m_sharedMemoryPyramidI420.size()]};
+                    if (updateDemand(area, READER_TIMEOUT, pyramidDemanded[i])) {
+                        withPyramid = true;
+                    }
+                }
+                if (withPyramid) {
+                    for (uint32_t level{0}; level < m_sharedMemoryPyramidI420.size(); level++) {
+                        destinations.pyramidI420[level] = m_sharedMemoryPyramidI420[level]->beginWrite(ts);
+                        outputs.push_back(m_sharedMemoryPyramidI420[level].get());
+                    }
+                    for (uint32_t level{0}; level < m_sharedMemoryPyramidARGB.size(); level++) {
+                        destinations.pyramidARGB[level] = m_sharedMemoryPyramidARGB[level]->beginWrite(ts);
+                        outputs.push_back(m_sharedMemoryPyramidARGB[level].get());
+                    }
+                }
+                uint8_t *i420{destinations.i420};
+                uint8_t *argb{destinations.argb};
+                m_frameConverter->convert(reinterpret_cast<uint8_t *>(image->GetData()), destinations);
+                metadata.conversionDoneTime = cluon::time::toMicroseconds(cluon::time::now());
+                metadata.flags |= layout::METADATA_CONVERSION_DONE_TIME;
+                for (auto area : outputs) {
+                    area->endWrite(metadata);
+                    area->notifyAll();
+                }
+                if (WITH_HDR_NOW) {
+                    m_sharedMemoryHDR->endWrite(metadata);
+                    m_sharedMemoryHDR->notifyAll();
+                }
+                if (WITH_I420_NOW) {
+                    m_sharedMemoryI420->endWrite(metadata);
+                    if (nullptr != m_frameSetArea) {
+                        m_frameSetArea->add(m_configuration.index, metadata, i420);
+                    }
+                }
+                if (WITH_ARGB_NOW) {
+                    if (m_configuration.verbose) {
+                        m_ximage->data = reinterpret_cast<char *>(argb);
+                        XPutImage(m_display, m_window, DefaultGC(m_display, 0), m_ximage, 0, 0, 0, 0, WIDTH, HEIGHT);
+                    }
+                    m_sharedMemoryARGB->endWrite(metadata);
+                }
+
+                // Wake up any pending processes.
+                if (WITH_I420_NOW) {
+                    m_sharedMemoryI420->notifyAll();
+                }
+                if (WITH_ARGB_NOW) {
+                    m_sharedMemoryARGB->notifyAll();
+                }
+
+                if (firstFrame) {
+                    firstFrame = false;
+                    reportStartup();
+                }
+                if (0 != m_lostSince.load()) {
+                    reportRecovery(m_lostSince.exchange(0));
+                }
+            } else {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Grabbed frame of size " << width << "x" << height << " does not match size of shared memory!" << std::endl;
+            }
+            releaseFrame(frame);
+        }
+    }
+}
+
+void CameraPipeline::reportStartup() noexcept {
+    const int64_t STARTUP_TIME{(cluon::time::toMicroseconds(cluon::time::now()) - m_configuration.startTime) / 1000};
+    std::clog << "[opendlv-device-camera-spinnaker]: First frame of camera '" << m_configuration.serialNumber << "' published " << STARTUP_TIME << " ms after start." << std::endl;
+    if ((nullptr != m_od4) && m_od4->isRunning()) {
+        opendlv::system::SystemOperationState msg;
+        msg.code(static_cast<int32_t>(STARTUP_TIME)).description("startup time in ms");
+        m_od4->send(msg, cluon::time::now(), m_configuration.senderStamp);
+    }
+}
+
+void CameraPipeline::reportRecovery(int64_t lostSince) noexcept {
+    const int64_t RECOVERY_TIME{(cluon::time::toMicroseconds(cluon::time::now()) - lostSince) / 1000};
+    std::clog << "[opendlv-device-camera-spinnaker]: Camera '" << m_configuration.serialNumber << "' recovered after " << RECOVERY_TIME << " ms (" << m_recoveries.load() << " recoveries so far)." << std::endl;
+    if ((nullptr != m_od4) && m_od4->isRunning()) {
+        opendlv::system::SystemOperationState msg;
+        msg.code(static_cast<int32_t>(RECOVERY_TIME)).description("recovery time in ms; recoveries=" + std::to_string(m_recoveries.load()));
+        m_od4->send(msg, cluon::time::now(), m_configuration.senderStamp);
+    }
+}
+
+void CameraPipeline::reportStatistics() noexcept {
+    StreamStatistics::Report report;
+    {
+        // Without a camera, only the frame counters are sampled.
+        std::lock_guard<std::mutex> lck(m_cameraMutex);
+        Spinnaker::GenApi::INodeMap *streamNodeMap{m_camera.IsValid() ? &m_camera->GetTLStreamNodeMap() : nullptr};
+        report = m_streamStatistics.sample(streamNodeMap, m_frameQueue->dropped());
+        tunePacketDelay(report);
+    }
+    if (0 == m_configuration.statisticsPeriod) {
+        return;
+    }
+    const std::string DESCRIPTION{report.toString() + " recoveries=" + std::to_string(m_recoveries.load())};
+    std::clog << "[opendlv-device-camera-spinnaker]: Stream statistics of camera '" << m_configuration.serialNumber << "': " << DESCRIPTION << std::endl;
+    if ((nullptr != m_od4) && m_od4->isRunning()) {
+        opendlv::system::NetworkStatusMessage msg;
+        msg.code(static_cast<int32_t>(report.lost())).description(DESCRIPTION);
+        m_od4->send(msg, cluon::time::now(), m_configuration.senderStamp);
+    }
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAMERA_PIPELINE_HPP
+#define CAMERA_PIPELINE_HPP
+
+#include "cluon-complete.hpp"
+#include "frame-converter.hpp"
+#include "frame-event-handler.hpp"
+#include "frame-queue.hpp"
+#include "frame-set-area.hpp"
+#include "frame.hpp"
+#include "remap-table.hpp"
+#include "shared-memory-area.hpp"
+#include "stream-statistics.hpp"
+#include "user-buffer-pool.hpp"
+#include "worker-pool.hpp"
+
+#include <Spinnaker.h>
+
+#include <X11/Xlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Acquisition and conversion of one camera: the camera's frames are grabbed
+ * on an acquisition thread, handed over through a frame queue, and converted
+ * into the camera's shared memory areas on a conversion thread. All pipelines
+ * of a process share the Spinnaker system and the conversion worker pool.
+ * If the camera is lost, a supervision thread re-initializes it as soon as
+ * it is back while the shared memory areas stay in place.
+ */
+class CameraPipeline {
+   public:
+    // Free running, trigger source for the other cameras, or triggered by a line.
+    enum class Trigger { OFF, MASTER, SLAVE };
+
+    // Pixel format on the wire; Bayer frames are demosaiced on the host.
+    enum class PixelFormat { YUV422, MONO8, MONO12P, MONO16, BAYER8, BAYER12P };
+
+    // Output formats in addition to I420 and ARGB.
+    enum class OutputFormat { NV12, BGR24, RGB24, RGB_PLANAR, UYVY };
+
+    /**
+     * @param format Name of an output format ("nv12", "bgr24", "rgb24", "rgbp", or "uyvy").
+     * @param outputFormat Parsed format.
+     * @return true if the name is known.
+     */
+    static bool outputFormatFromString(const std::string &format, OutputFormat &outputFormat) noexcept;
+
+    struct Output {
+        OutputFormat format{OutputFormat::NV12};
+        std::string name{};
+    };
+
+    struct Configuration {
+        // Position of the camera in --camera and in a frame set.
+        uint32_t index{0};
+        uint32_t serialNumber{0};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t offsetX{0};
+        uint32_t offsetY{0};
+        float fps{17};
+        std::string nameI420{};
+        std::string nameARGB{};
+        std::string nameNative{};
+        // Area for the unpacked 16-bit frames of high bit depth formats.
+        std::string nameHDR{};
+        // Areas for further output formats.
+        std::vector<Output> outputs{};
+        // Number of pyramid levels below the full resolution.
+        uint32_t pyramidLevels{0};
+        // Regions published on their own, and the suffixes of their areas' names.
+        std::vector<FrameConverter::Crop> crops{};
+        std::vector<std::string> cropNames{};
+        // Normalised tensor for inference, and the name of its area.
+        FrameConverter::Tensor tensor{};
+        std::string nameTensor{};
+        // Calibration for the undistorted outputs; none if invalid.
+        RemapTable::Calibration calibration{};
+        uint32_t nativeBuffers{8};
+        SharedMemoryArea::Mode publishMode{SharedMemoryArea::Mode::LOCK};
+        uint32_t ringSlots{3};
+        uint32_t queueSize{3};
+        FrameQueue<Frame>::DropPolicy queueDropPolicy{FrameQueue<Frame>::DropPolicy::DROP_OLDEST};
+        Trigger trigger{Trigger::OFF};
+        // Line on which the master outputs its exposure signal.
+        std::string triggerOutput{"Line1"};
+        // Line on which a slave receives the trigger.
+        std::string triggerInput{"Line3"};
+        // GigE packet size in bytes; 0 to keep the camera's setting.
+        int64_t packetSize{0};
+        // Use the largest packet size that the network path supports.
+        bool autoPacketSize{false};
+        // GigE inter-packet delay in ticks; negative to keep the camera's setting.
+        int64_t packetDelay{-1};
+        // Adapt the inter-packet delay to the lost packets.
+        bool autoPacketDelay{false};
+        bool eventAcquisition{false};
+        bool skipARGB{false};
+        // Milliseconds after the last read of an output until it is no longer produced; 0 to always produce all outputs.
+        uint32_t readerTimeout{0};
+        bool noCameraTimestamp{false};
+        bool noChunkData{false};
+        PixelFormat pixelFormat{PixelFormat::YUV422};
+        kernels::Demosaic demosaic{kernels::Demosaic::BILINEAR};
+        // Table mapping high bit depth frames to 8 bits (cf. ToneMap).
+        std::vector<uint8_t> toneMap{};
+        bool verbose{false};
+        bool debug{false};
+        // Seconds between two stream statistics reports; 0 to disable.
+        uint32_t statisticsPeriod{1};
+        // Sender stamp of the NetworkStatusMessage.
+        uint32_t senderStamp{0};
+        // Host time in microseconds when the process was started.
+        int64_t startTime{0};
+    };
+
+   private:
+    CameraPipeline(const CameraPipeline &) = delete;
+    CameraPipeline(CameraPipeline &&)      = delete;
+    CameraPipeline &operator=(const CameraPipeline &) = delete;
+    CameraPipeline &operator=(CameraPipeline &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param configuration Settings for this camera.
+     * @param workerPool Threads to convert the frames on.
+     * @param od4 OD4Session to send the stream statistics to; nullptr for none.
+     * @param frameSetArea Area to add the converted I420 frames to; nullptr for none.
+     * @param findCamera Delegate to find the camera with a given serial number again after it was lost.
+     */
+    CameraPipeline(const Configuration &configuration, WorkerPool &workerPool, cluon::OD4Session *od4, FrameSetArea *frameSetArea, std::function<Spinnaker::CameraPtr(uint32_t)> findCamera) noexcept;
+    ~CameraPipeline();
+
+   public:
+    uint32_t serialNumber() const noexcept;
+    const Configuration &configuration() const noexcept;
+
+    /**
+     * @return Throughput of the opened camera on the wire in bytes per second, including packet overhead.
+     */
+    double requiredThroughput() noexcept;
+
+    /**
+     * This method limits the throughput of the camera, either directly or
+     * by an inter-packet delay; the limit is kept across reconnects.
+     *
+     * @param bytesPerSecond Throughput limit.
+     * @param linkCapacity Capacity of the link in bytes per second.
+     * @return true if the limit was applied.
+     */
+    bool limitThroughput(double bytesPerSecond, double linkCapacity) noexcept;
+
+    /**
+     * This method staggers the acquisition of the camera against the others
+     * sharing its link: every start and restart of the acquisition waits for
+     * the next frame period boundary at the given offset after the epoch.
+     *
+     * @param epoch Common time point of the cameras.
+     * @param offset Offset in microseconds after the epoch.
+     */
+    void setStartPhase(std::chrono::steady_clock::time_point epoch, int64_t offset) noexcept;
+
+    /**
+     * This method creates the shared memory areas, initializes and configures
+     * the camera, and prepares its stream buffers.
+     *
+     * @param camera Camera with the configured serial number.
+     * @return true on success.
+     */
+    bool open(Spinnaker::CameraPtr camera) noexcept;
+
+    /**
+     * This method starts the acquisition and the acquisition and conversion threads.
+     */
+    void start();
+
+    /**
+     * This method stops the threads and the acquisition and releases the camera.
+     */
+    void stop() noexcept;
+
+    /**
+     * This method is called when the camera showed up on an interface.
+     */
+    void onDeviceArrival() noexcept;
+
+    /**
+     * This method is called when the camera disappeared from its interface.
+     */
+    void onDeviceRemoval() noexcept;
+
+   private:
+    bool initialize(Spinnaker::CameraPtr camera) noexcept;
+    void deinitialize() noexcept;
+    bool configureTrigger(Spinnaker::GenApi::INodeMap &nodeMap) noexcept;
+    bool configurePixelFormat(Spinnaker::GenApi::INodeMap &nodeMap) noexcept;
+    void configureTransport(Spinnaker::GenApi::INodeMap &nodeMap) noexcept;
+    void tunePacketDelay(const StreamStatistics::Report &report) noexcept;
+    void waitForStartPhase() noexcept;
+    void startStreaming();
+    void stopStreaming() noexcept;
+    void supervise() noexcept;
+    void acquire() noexcept;
+    void convert() noexcept;
+    void reportStartup() noexcept;
+    void reportRecovery(int64_t lostSince) noexcept;
+    void reportStatistics() noexcept;
+
+   private:
+    const Configuration m_configuration;
+    WorkerPool &m_workerPool;
+    cluon::OD4Session *m_od4;
+    FrameSetArea *m_frameSetArea;
+    std::function<Spinnaker::CameraPtr(uint32_t)> m_findCamera;
+
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryI420{nullptr};
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryARGB{nullptr};
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryHDR{nullptr};
+    // Areas of the further output formats in the order of the configuration.
+    std::vector<std::unique_ptr<SharedMemoryArea>> m_sharedMemoryOutputs{};
+    // Areas of the pyramid levels 1, 2, ...; the ARGB levels only if ARGB is produced.
+    std::vector<std::unique_ptr<SharedMemoryArea>> m_sharedMemoryPyramidI420{};
+    std::vector<std::unique_ptr<SharedMemoryArea>> m_sharedMemoryPyramidARGB{};
+    // Areas of the crops in the order of FrameConverter::crops(); the ARGB crops only if ARGB is produced.
+    std::vector<std::unique_ptr<SharedMemoryArea>> m_sharedMemoryCropI420{};
+    std::vector<std::unique_ptr<SharedMemoryArea>> m_sharedMemoryCropARGB{};
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryTensor{nullptr};
+    // Areas of the undistorted frames; the ARGB frames only if ARGB is produced.
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryUndistortedI420{nullptr};
+    std::unique_ptr<SharedMemoryArea> m_sharedMemoryUndistortedARGB{nullptr};
+    std::unique_ptr<UserBufferPool> m_userBufferPool{nullptr};
+    std::unique_ptr<FrameConverter> m_frameConverter{nullptr};
+    std::unique_ptr<FrameQueue<Frame>> m_frameQueue{nullptr};
+    std::unique_ptr<FrameEventHandler> m_frameEventHandler{nullptr};
+    StreamStatistics m_streamStatistics{};
+
+    Spinnaker::CameraPtr m_camera{nullptr};
+    bool m_withChunkData{false};
+    // Pixel format of the camera frames as selected on the camera.
+    FrameConverter::PixelFormat m_cameraPixelFormat{FrameConverter::PixelFormat::UYVY};
+    kernels::BayerPattern m_bayerPattern{kernels::BayerPattern::RGGB};
+    uint32_t m_cameraFourcc{0};
+    // Pixel format of the unpacked 16-bit frames.
+    uint32_t m_hdrFourcc{0};
+    // Current inter-packet delay; negative if unknown.
+    int64_t m_packetDelay{-1};
+    // Inter-packet delay that keeps the camera within its share of the link.
+    int64_t m_minimumPacketDelay{0};
+    // Throughput limit in bytes per second; 0 for none.
+    int64_t m_throughputLimit{0};
+    uint32_t m_periodsWithoutLoss{0};
+    bool m_acquiring{false};
+    // Phase of the acquisition starts; negative offset for unstaggered starts.
+    std::chrono::steady_clock::time_point m_startEpoch{};
+    int64_t m_startOffset{-1};
+
+    Display *m_display{nullptr};
+    Window m_window{0};
+    XImage *m_ximage{nullptr};
+
+    // Held while the camera or one of its frames is in use.
+    std::mutex m_cameraMutex{};
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_deviceLost{false};
+    // Incremented whenever streaming stops; frames of an older stream are stale.
+    std::atomic<uint64_t> m_streamGeneration{0};
+    std::mutex m_supervisionMutex{};
+    std::condition_variable m_supervisionCondition{};
+    // Host time in microseconds when the camera was lost until its first frame after a recovery.
+    std::atomic<int64_t> m_lostSince{0};
+    std::atomic<uint32_t> m_recoveries{0};
+
+    std::thread m_acquisition{};
+    std::thread m_conversion{};
+    std::thread m_supervision{};
+};
+
+#endif
@@ -0,0 +1,1442 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "conversion-kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace kernels {
+
+namespace {
+
+// BT.601 limited range in 6-bit fixed point.
+constexpr int32_t YG{74};
+constexpr int32_t VR{102};
+constexpr int32_t UG{-25};
+constexpr int32_t VG{-52};
+constexpr int32_t UB{129};
+
+enum class Isa { SCALAR, SSE2, AVX2 };
+
+Isa detectIsa() noexcept {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Isa::SSE2;
+    }
+#endif
+    return Isa::SCALAR;
+}
+
+Isa isa() noexcept {
+    static const Isa ISA{detectIsa()};
+    return ISA;
+}
+
+// Conversions between single and half precision need F16C besides AVX2.
+bool hasF16C() noexcept {
+#ifdef HAVE_X86_KERNELS
+    static const bool F16C{[]() {
+        uint32_t eax{0}, ebx{0}, ecx{0}, edx{0};
+        return (0 != __get_cpuid(1, &eax, &ebx, &ecx, &edx)) && (0 != (ecx & bit_F16C));
+    }()};
+    return F16C;
+#else
+    return false;
+#endif
+}
+
+inline int32_t saturate16(int32_t x) noexcept {
+    return (x < -32768) ? -32768 : ((x > 32767) ? 32767 : x);
+}
+
+inline uint8_t toByte(int32_t x) noexcept {
+    const int32_t v{saturate16(x + 32) >> 6};
+    return static_cast<uint8_t>((v < 0) ? 0 : ((v > 255) ? 255 : v));
+}
+
+inline void yuvToARGB(uint8_t y, int32_t cr, int32_t cg, int32_t cb, uint8_t *argb) noexcept {
+    const int32_t yp{(static_cast<int32_t>(y) - 16) * YG};
+    argb[0] = toByte(saturate16(yp + cb));
+    argb[1] = toByte(saturate16(yp + cg));
+    argb[2] = toByte(saturate16(yp + cr));
+    argb[3] = 255;
+}
+
+void uyvyRowPairScalar(const uint8_t *src0, const uint8_t *src1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x + 1 < width; x += 2) {
+        const uint8_t *p0{src0 + 2 * x};
+        const uint8_t *p1{src1 + 2 * x};
+        const uint8_t U{static_cast<uint8_t>((p0[0] + p1[0] + 1) >> 1)};
+        const uint8_t V{static_cast<uint8_t>((p0[2] + p1[2] + 1) >> 1)};
+        y0[x]     = p0[1];
+        y0[x + 1] = p0[3];
+        y1[x]     = p1[1];
+        y1[x + 1] = p1[3];
+        u[x / 2]  = U;
+        v[x / 2]  = V;
+        if (nullptr != argb0) {
+            const int32_t uu{static_cast<int32_t>(U) - 128};
+            const int32_t vv{static_cast<int32_t>(V) - 128};
+            const int32_t cr{vv * VR};
+            const int32_t cg{uu * UG + vv * VG};
+            const int32_t cb{uu * UB};
+            yuvToARGB(p0[1], cr, cg, cb, argb0 + 4 * x);
+            yuvToARGB(p0[3], cr, cg, cb, argb0 + 4 * (x + 1));
+            yuvToARGB(p1[1], cr, cg, cb, argb1 + 4 * x);
+            yuvToARGB(p1[3], cr, cg, cb, argb1 + 4 * (x + 1));
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Converts eight pixels given as 16-bit Y and per-pixel chroma terms into 8 ARGB pixels.
+inline void argbFromTermsSSE2(__m128i y16, __m128i cr, __m128i cg, __m128i cb, uint8_t *argb) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i MAX{_mm_set1_epi16(255)};
+    const __m128i ROUND{_mm_set1_epi16(32)};
+    const __m128i yp{_mm_mullo_epi16(_mm_sub_epi16(y16, _mm_set1_epi16(16)), _mm_set1_epi16(YG))};
+    const __m128i b{_mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yp, cb), ROUND), 6), ZERO), MAX)};
+    const __m128i g{_mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yp, cg), ROUND), 6), ZERO), MAX)};
+    const __m128i r{_mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yp, cr), ROUND), 6), ZERO), MAX)};
+    const __m128i bg{_mm_or_si128(b, _mm_slli_epi16(g, 8))};
+    const __m128i ra{_mm_or_si128(r, _mm_set1_epi16(static_cast<int16_t>(0xFF00)))};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(argb), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(argb + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+// Converts 16 pixels of a UYVY row pair; returns the number of pixels processed.
+uint32_t uyvyRowPairSSE2(const uint8_t *src0, const uint8_t *src1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t width) noexcept {
+    const __m128i LOW{_mm_set1_epi16(0x00FF)};
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i BIAS{_mm_set1_epi16(128)};
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i r0a{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src0 + 2 * x))};
+        const __m128i r0b{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src0 + 2 * x + 16))};
+        const __m128i r1a{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src1 + 2 * x))};
+        const __m128i r1b{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src1 + 2 * x + 16))};
+
+        const __m128i y0a{_mm_srli_epi16(r0a, 8)};
+        const __m128i y0b{_mm_srli_epi16(r0b, 8)};
+        const __m128i y1a{_mm_srli_epi16(r1a, 8)};
+        const __m128i y1b{_mm_srli_epi16(r1b, 8)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y0 + x), _mm_packus_epi16(y0a, y0b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y1 + x), _mm_packus_epi16(y1a, y1b));
+
+        // U, V interleaved as 16-bit values, averaged over both rows.
+        const __m128i uva{_mm_avg_epu16(_mm_and_si128(r0a, LOW), _mm_and_si128(r1a, LOW))};
+        const __m128i uvb{_mm_avg_epu16(_mm_and_si128(r0b, LOW), _mm_and_si128(r1b, LOW))};
+        const __m128i uv{_mm_packus_epi16(uva, uvb)};
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x / 2), _mm_packus_epi16(_mm_and_si128(uv, LOW), ZERO));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x / 2), _mm_packus_epi16(_mm_srli_epi16(uv, 8), ZERO));
+
+        if (nullptr != argb0) {
+            // Replicate each chroma sample for both pixels of its pair.
+            const __m128i ua{_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(uva, 0xA0), 0xA0), BIAS)};
+            const __m128i va{_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(uva, 0xF5), 0xF5), BIAS)};
+            const __m128i ub{_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(uvb, 0xA0), 0xA0), BIAS)};
+            const __m128i vb{_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(uvb, 0xF5), 0xF5), BIAS)};
+            const __m128i cra{_mm_mullo_epi16(va, _mm_set1_epi16(VR))};
+            const __m128i cga{_mm_add_epi16(_mm_mullo_epi16(ua, _mm_set1_epi16(UG)), _mm_mullo_epi16(va, _mm_set1_epi16(VG)))};
+            const __m128i cba{_mm_mullo_epi16(ua, _mm_set1_epi16(UB))};
+            const __m128i crb{_mm_mullo_epi16(vb, _mm_set1_epi16(VR))};
+            const __m128i cgb{_mm_add_epi16(_mm_mullo_epi16(ub, _mm_set1_epi16(UG)), _mm_mullo_epi16(vb, _mm_set1_epi16(VG)))};
+            const __m128i cbb{_mm_mullo_epi16(ub, _mm_set1_epi16(UB))};
+            argbFromTermsSSE2(y0a, cra, cga, cba, argb0 + 4 * x);
+            argbFromTermsSSE2(y0b, crb, cgb, cbb, argb0 + 4 * x + 32);
+            argbFromTermsSSE2(y1a, cra, cga, cba, argb1 + 4 * x);
+            argbFromTermsSSE2(y1b, crb, cgb, cbb, argb1 + 4 * x + 32);
+        }
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline void argbFromTermsAVX2(__m256i y16, __m256i cr, __m256i cg, __m256i cb, uint8_t *argb) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i MAX{_mm256_set1_epi16(255)};
+    const __m256i ROUND{_mm256_set1_epi16(32)};
+    const __m256i yp{_mm256_mullo_epi16(_mm256_sub_epi16(y16, _mm256_set1_epi16(16)), _mm256_set1_epi16(YG))};
+    const __m256i b{_mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yp, cb), ROUND), 6), ZERO), MAX)};
+    const __m256i g{_mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yp, cg), ROUND), 6), ZERO), MAX)};
+    const __m256i r{_mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yp, cr), ROUND), 6), ZERO), MAX)};
+    const __m256i bg{_mm256_or_si256(b, _mm256_slli_epi16(g, 8))};
+    const __m256i ra{_mm256_or_si256(r, _mm256_set1_epi16(static_cast<int16_t>(0xFF00)))};
+    // Unpacking works per 128-bit lane; restore the pixel order afterwards.
+    const __m256i lo{_mm256_unpacklo_epi16(bg, ra)};
+    const __m256i hi{_mm256_unpackhi_epi16(bg, ra)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// Converts 32 pixels of a UYVY row pair; returns the number of pixels processed.
+__attribute__((target("avx2")))
+uint32_t uyvyRowPairAVX2(const uint8_t *src0, const uint8_t *src1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t width) noexcept {
+    const __m256i LOW{_mm256_set1_epi16(0x00FF)};
+    const __m256i BIAS{_mm256_set1_epi16(128)};
+    const __m256i SPLIT{_mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                         0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15)};
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i r0a{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src0 + 2 * x))};
+        const __m256i r0b{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src0 + 2 * x + 32))};
+        const __m256i r1a{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src1 + 2 * x))};
+        const __m256i r1b{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src1 + 2 * x + 32))};
+
+        const __m256i y0a{_mm256_srli_epi16(r0a, 8)};
+        const __m256i y0b{_mm256_srli_epi16(r0b, 8)};
+        const __m256i y1a{_mm256_srli_epi16(r1a, 8)};
+        const __m256i y1b{_mm256_srli_epi16(r1b, 8)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y0 + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(y0a, y0b), 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y1 + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(y1a, y1b), 0xD8));
+
+        // U, V interleaved as 16-bit values, averaged over both rows.
+        const __m256i uva{_mm256_avg_epu16(_mm256_and_si256(r0a, LOW), _mm256_and_si256(r1a, LOW))};
+        const __m256i uvb{_mm256_avg_epu16(_mm256_and_si256(r0b, LOW), _mm256_and_si256(r1b, LOW))};
+        const __m256i uv{_mm256_permute4x64_epi64(_mm256_packus_epi16(uva, uvb), 0xD8)};
+        const __m256i planar{_mm256_permute4x64_epi64(_mm256_shuffle_epi8(uv, SPLIT), 0xD8)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + x / 2), _mm256_castsi256_si128(planar));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x / 2), _mm256_extracti128_si256(planar, 1));
+
+        if (nullptr != argb0) {
+            // Replicate each chroma sample for both pixels of its pair.
+            const __m256i ua{_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uva, 0xA0), 0xA0), BIAS)};
+            const __m256i va{_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uva, 0xF5), 0xF5), BIAS)};
+            const __m256i ub{_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uvb, 0xA0), 0xA0), BIAS)};
+            const __m256i vb{_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uvb, 0xF5), 0xF5), BIAS)};
+            const __m256i cra{_mm256_mullo_epi16(va, _mm256_set1_epi16(VR))};
+            const __m256i cga{_mm256_add_epi16(_mm256_mullo_epi16(ua, _mm256_set1_epi16(UG)), _mm256_mullo_epi16(va, _mm256_set1_epi16(VG)))};
+            const __m256i cba{_mm256_mullo_epi16(ua, _mm256_set1_epi16(UB))};
+            const __m256i crb{_mm256_mullo_epi16(vb, _mm256_set1_epi16(VR))};
+            const __m256i cgb{_mm256_add_epi16(_mm256_mullo_epi16(ub, _mm256_set1_epi16(UG)), _mm256_mullo_epi16(vb, _mm256_set1_epi16(VG)))};
+            const __m256i cbb{_mm256_mullo_epi16(ub, _mm256_set1_epi16(UB))};
+            argbFromTermsAVX2(y0a, cra, cga, cba, argb0 + 4 * x);
+            argbFromTermsAVX2(y0b, crb, cgb, cbb, argb0 + 4 * x + 64);
+            argbFromTermsAVX2(y1a, cra, cga, cba, argb1 + 4 * x);
+            argbFromTermsAVX2(y1b, crb, cgb, cbb, argb1 + 4 * x + 64);
+        }
+    }
+    return x;
+}
+#endif
+
+void greyRowScalar(const uint8_t *y, uint8_t *argb, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        yuvToARGB(y[x], 0, 0, 0, argb + 4 * x);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Converts 16 grey pixels per iteration; returns the number of pixels processed.
+uint32_t greyRowSSE2(const uint8_t *y, uint8_t *argb, uint32_t width) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i yy{_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x))};
+        argbFromTermsSSE2(_mm_unpacklo_epi8(yy, ZERO), ZERO, ZERO, ZERO, argb + 4 * x);
+        argbFromTermsSSE2(_mm_unpackhi_epi8(yy, ZERO), ZERO, ZERO, ZERO, argb + 4 * x + 32);
+    }
+    return x;
+}
+
+// Converts 32 grey pixels per iteration; returns the number of pixels processed.
+__attribute__((target("avx2")))
+uint32_t greyRowAVX2(const uint8_t *y, uint8_t *argb, uint32_t width) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        // Widen 16 pixels at a time so that argbFromTermsAVX2 sees them in order.
+        const __m256i lo{_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)))};
+        const __m256i hi{_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x + 16)))};
+        argbFromTermsAVX2(lo, ZERO, ZERO, ZERO, argb + 4 * x);
+        argbFromTermsAVX2(hi, ZERO, ZERO, ZERO, argb + 4 * x + 64);
+    }
+    return x;
+}
+#endif
+
+// BT.601 limited range in 8-bit fixed point for RGB to YUV; the luma bias
+// includes the offset of 16, the chroma sums of four pixels are 10-bit.
+constexpr int32_t RY{66};
+constexpr int32_t GY{129};
+constexpr int32_t BY{25};
+constexpr int32_t Y_BIAS{128 + (16 << 8)};
+constexpr int32_t RU{-38};
+constexpr int32_t GU{-74};
+constexpr int32_t BU{112};
+constexpr int32_t RV{112};
+constexpr int32_t GV{-94};
+constexpr int32_t BV{-18};
+constexpr int32_t UV_ROUND{512};
+constexpr int32_t UV_BIAS{128 << 10};
+
+// Line buffers are padded by mirrored pixels for the demosaicing neighbourhood.
+constexpr uint32_t PAD{2};
+constexpr uint32_t RAW_LINES{8};
+constexpr uint32_t GREEN_LINES{4};
+constexpr uint32_t RGB_LINES{6};
+
+inline uint32_t lineStride(uint32_t width) noexcept {
+    return (width + 2 * PAD + 63) / 64 * 64;
+}
+
+// @return Two 16-bit factors as one 32-bit value for _mm_madd_epi16.
+constexpr int32_t factorPair(int32_t low, int32_t high) noexcept {
+    return static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(high)) << 16) | static_cast<uint32_t>(static_cast<uint16_t>(low)));
+}
+
+inline uint8_t avg(uint8_t a, uint8_t b) noexcept {
+    return static_cast<uint8_t>((a + b + 1) >> 1);
+}
+
+inline uint8_t clampByte(int32_t x) noexcept {
+    return static_cast<uint8_t>((x < 0) ? 0 : ((x > 255) ? 255 : x));
+}
+
+// All row functions below process the columns [first, width) and expect
+// padded lines; parity is the column parity of the row's red or blue sites.
+
+void bilinearRowScalar(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint32_t parity, uint8_t *own, uint8_t *green, uint8_t *other, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        const uint8_t *u{up + x};
+        const uint8_t *m{mid + x};
+        const uint8_t *d{down + x};
+        const uint8_t H{avg(m[-1], m[1])};
+        const uint8_t V{avg(u[0], d[0])};
+        if (parity == (x & 1)) {
+            own[x]   = m[0];
+            green[x] = avg(H, V);
+            other[x] = avg(avg(u[-1], u[1]), avg(d[-1], d[1]));
+        } else {
+            own[x]   = H;
+            green[x] = m[0];
+            other[x] = V;
+        }
+    }
+}
+
+// Hamilton-Adams: green is interpolated along the direction with the smaller
+// gradient and corrected by the Laplacian of the site's own colour.
+inline int32_t greenEstimate(int32_t m2, int32_t m1, int32_t c, int32_t p1, int32_t p2, int32_t u2, int32_t u1, int32_t d1, int32_t d2) noexcept {
+    const int32_t LH{2 * c - m2 - p2};
+    const int32_t LV{2 * c - u2 - d2};
+    const int32_t GRADIENT_H{std::abs(m1 - p1) + std::abs(LH)};
+    const int32_t GRADIENT_V{std::abs(u1 - d1) + std::abs(LV)};
+    const int32_t EH{(2 * (m1 + p1) + LH + 2) >> 2};
+    const int32_t EV{(2 * (u1 + d1) + LV + 2) >> 2};
+    return (GRADIENT_H < GRADIENT_V) ? EH : ((GRADIENT_V < GRADIENT_H) ? EV : ((EH + EV + 1) >> 1));
+}
+
+void greenRowScalar(const uint8_t *up2, const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *down2, uint32_t parity, uint8_t *green, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        const uint8_t *m{mid + x};
+        green[x] = (parity == (x & 1)) ? clampByte(greenEstimate(m[-2], m[-1], m[0], m[1], m[2], up2[x], up[x], down[x], down2[x])) : m[0];
+    }
+}
+
+// Red and blue are interpolated as differences to the full green lines.
+void colourRowScalar(const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *gUp, const uint8_t *gMid, const uint8_t *gDown, uint32_t parity, uint8_t *own, uint8_t *other, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        const uint8_t *u{up + x};
+        const uint8_t *m{mid + x};
+        const uint8_t *d{down + x};
+        const uint8_t *gu{gUp + x};
+        const uint8_t *gm{gMid + x};
+        const uint8_t *gd{gDown + x};
+        const int32_t G{gm[0]};
+        if (parity == (x & 1)) {
+            const int32_t DR{avg(avg(u[-1], u[1]), avg(d[-1], d[1]))};
+            const int32_t DG{avg(avg(gu[-1], gu[1]), avg(gd[-1], gd[1]))};
+            own[x]   = m[0];
+            other[x] = clampByte(G + DR - DG);
+        } else {
+            own[x]   = clampByte(G + avg(m[-1], m[1]) - avg(gm[-1], gm[1]));
+            other[x] = clampByte(G + avg(u[0], d[0]) - avg(gu[0], gd[0]));
+        }
+    }
+}
+
+void rgbRowPairScalar(const uint8_t *r0, const uint8_t *g0, const uint8_t *b0, const uint8_t *r1, const uint8_t *g1, const uint8_t *b1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x + 1 < width; x += 2) {
+        for (uint32_t i{x}; i < x + 2; i++) {
+            y0[i] = static_cast<uint8_t>((RY * r0[i] + GY * g0[i] + BY * b0[i] + Y_BIAS) >> 8);
+            y1[i] = static_cast<uint8_t>((RY * r1[i] + GY * g1[i] + BY * b1[i] + Y_BIAS) >> 8);
+        }
+        const int32_t R{r0[x] + r0[x + 1] + r1[x] + r1[x + 1]};
+        const int32_t G{g0[x] + g0[x + 1] + g1[x] + g1[x + 1]};
+        const int32_t B{b0[x] + b0[x + 1] + b1[x] + b1[x + 1]};
+        u[x / 2] = static_cast<uint8_t>((RU * R + GU * G + BU * B + UV_ROUND + UV_BIAS) >> 10);
+        v[x / 2] = static_cast<uint8_t>((RV * R + GV * G + BV * B + UV_ROUND + UV_BIAS) >> 10);
+        if (nullptr != argb0) {
+            for (uint32_t i{x}; i < x + 2; i++) {
+                argb0[4 * i]     = b0[i];
+                argb0[4 * i + 1] = g0[i];
+                argb0[4 * i + 2] = r0[i];
+                argb0[4 * i + 3] = 255;
+                argb1[4 * i]     = b1[i];
+                argb1[4 * i + 1] = g1[i];
+                argb1[4 * i + 2] = r1[i];
+                argb1[4 * i + 3] = 255;
+            }
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+inline __m128i loadSSE2(const uint8_t *p) noexcept {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b) noexcept {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// @return Mask selecting the bytes at the columns of the given parity.
+inline __m128i parityMaskSSE2(uint32_t parity) noexcept {
+    return _mm_set1_epi16((0 == parity) ? 0x00FF : static_cast<int16_t>(0xFF00));
+}
+
+uint32_t bilinearRowSSE2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint32_t parity, uint8_t *own, uint8_t *green, uint8_t *other, uint32_t width) noexcept {
+    const __m128i MASK{parityMaskSSE2(parity)};
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i c{loadSSE2(mid + x)};
+        const __m128i h{_mm_avg_epu8(loadSSE2(mid + x - 1), loadSSE2(mid + x + 1))};
+        const __m128i v{_mm_avg_epu8(loadSSE2(up + x), loadSSE2(down + x))};
+        const __m128i d{_mm_avg_epu8(_mm_avg_epu8(loadSSE2(up + x - 1), loadSSE2(up + x + 1)), _mm_avg_epu8(loadSSE2(down + x - 1), loadSSE2(down + x + 1)))};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(own + x), selectSSE2(MASK, c, h));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(green + x), selectSSE2(MASK, _mm_avg_epu8(h, v), c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(other + x), selectSSE2(MASK, d, v));
+    }
+    return x;
+}
+
+inline __m128i absSSE2(__m128i a) noexcept {
+    return _mm_max_epi16(a, _mm_sub_epi16(_mm_setzero_si128(), a));
+}
+
+inline __m128i greenEstimateSSE2(__m128i m2, __m128i m1, __m128i c, __m128i p1, __m128i p2, __m128i u2, __m128i u1, __m128i d1, __m128i d2) noexcept {
+    const __m128i c2{_mm_slli_epi16(c, 1)};
+    const __m128i lh{_mm_sub_epi16(_mm_sub_epi16(c2, m2), p2)};
+    const __m128i lv{_mm_sub_epi16(_mm_sub_epi16(c2, u2), d2)};
+    const __m128i gh{_mm_add_epi16(absSSE2(_mm_sub_epi16(m1, p1)), absSSE2(lh))};
+    const __m128i gv{_mm_add_epi16(absSSE2(_mm_sub_epi16(u1, d1)), absSSE2(lv))};
+    const __m128i eh{_mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(m1, p1), 1), lh), _mm_set1_epi16(2)), 2)};
+    const __m128i ev{_mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(u1, d1), 1), lv), _mm_set1_epi16(2)), 2)};
+    const __m128i mean{_mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(eh, ev), _mm_set1_epi16(1)), 1)};
+    return selectSSE2(_mm_cmplt_epi16(gh, gv), eh, selectSSE2(_mm_cmplt_epi16(gv, gh), ev, mean));
+}
+
+uint32_t greenRowSSE2(const uint8_t *up2, const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *down2, uint32_t parity, uint8_t *green, uint32_t width) noexcept {
+    const __m128i MASK{parityMaskSSE2(parity)};
+    const __m128i ZERO{_mm_setzero_si128()};
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i m2{loadSSE2(mid + x - 2)};
+        const __m128i m1{loadSSE2(mid + x - 1)};
+        const __m128i c{loadSSE2(mid + x)};
+        const __m128i p1{loadSSE2(mid + x + 1)};
+        const __m128i p2{loadSSE2(mid + x + 2)};
+        const __m128i u2{loadSSE2(up2 + x)};
+        const __m128i u1{loadSSE2(up + x)};
+        const __m128i d1{loadSSE2(down + x)};
+        const __m128i d2{loadSSE2(down2 + x)};
+        const __m128i lo{greenEstimateSSE2(_mm_unpacklo_epi8(m2, ZERO), _mm_unpacklo_epi8(m1, ZERO), _mm_unpacklo_epi8(c, ZERO), _mm_unpacklo_epi8(p1, ZERO), _mm_unpacklo_epi8(p2, ZERO),
+                                           _mm_unpacklo_epi8(u2, ZERO), _mm_unpacklo_epi8(u1, ZERO), _mm_unpacklo_epi8(d1, ZERO), _mm_unpacklo_epi8(d2, ZERO))};
+        const __m128i hi{greenEstimateSSE2(_mm_unpackhi_epi8(m2, ZERO), _mm_unpackhi_epi8(m1, ZERO), _mm_unpackhi_epi8(c, ZERO), _mm_unpackhi_epi8(p1, ZERO), _mm_unpackhi_epi8(p2, ZERO),
+                                           _mm_unpackhi_epi8(u2, ZERO), _mm_unpackhi_epi8(u1, ZERO), _mm_unpackhi_epi8(d1, ZERO), _mm_unpackhi_epi8(d2, ZERO))};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(green + x), selectSSE2(MASK, _mm_packus_epi16(lo, hi), c));
+    }
+    return x;
+}
+
+// @return g + a - b for 16 pixels, saturated to bytes.
+inline __m128i addDifferenceSSE2(__m128i g, __m128i a, __m128i b) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i lo{_mm_add_epi16(_mm_unpacklo_epi8(g, ZERO), _mm_sub_epi16(_mm_unpacklo_epi8(a, ZERO), _mm_unpacklo_epi8(b, ZERO)))};
+    const __m128i hi{_mm_add_epi16(_mm_unpackhi_epi8(g, ZERO), _mm_sub_epi16(_mm_unpackhi_epi8(a, ZERO), _mm_unpackhi_epi8(b, ZERO)))};
+    return _mm_packus_epi16(lo, hi);
+}
+
+uint32_t colourRowSSE2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *gUp, const uint8_t *gMid, const uint8_t *gDown, uint32_t parity, uint8_t *own, uint8_t *other, uint32_t width) noexcept {
+    const __m128i MASK{parityMaskSSE2(parity)};
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i g{loadSSE2(gMid + x)};
+        const __m128i hr{_mm_avg_epu8(loadSSE2(mid + x - 1), loadSSE2(mid + x + 1))};
+        const __m128i hg{_mm_avg_epu8(loadSSE2(gMid + x - 1), loadSSE2(gMid + x + 1))};
+        const __m128i vr{_mm_avg_epu8(loadSSE2(up + x), loadSSE2(down + x))};
+        const __m128i vg{_mm_avg_epu8(loadSSE2(gUp + x), loadSSE2(gDown + x))};
+        const __m128i dr{_mm_avg_epu8(_mm_avg_epu8(loadSSE2(up + x - 1), loadSSE2(up + x + 1)), _mm_avg_epu8(loadSSE2(down + x - 1), loadSSE2(down + x + 1)))};
+        const __m128i dg{_mm_avg_epu8(_mm_avg_epu8(loadSSE2(gUp + x - 1), loadSSE2(gUp + x + 1)), _mm_avg_epu8(loadSSE2(gDown + x - 1), loadSSE2(gDown + x + 1)))};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(own + x), selectSSE2(MASK, loadSSE2(mid + x), addDifferenceSSE2(g, hr, hg)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(other + x), selectSSE2(MASK, addDifferenceSSE2(g, dr, dg), addDifferenceSSE2(g, vr, vg)));
+    }
+    return x;
+}
+
+// Luma of 8 pixels given as 16-bit values.
+inline __m128i lumaSSE2(__m128i r, __m128i g, __m128i b) noexcept {
+    const __m128i RG{_mm_set1_epi32(factorPair(RY, GY))};
+    const __m128i B1{_mm_set1_epi32(factorPair(BY, Y_BIAS))};
+    const __m128i ONE{_mm_set1_epi16(1)};
+    const __m128i lo{_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), RG), _mm_madd_epi16(_mm_unpacklo_epi16(b, ONE), B1)), 8)};
+    const __m128i hi{_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), RG), _mm_madd_epi16(_mm_unpackhi_epi16(b, ONE), B1)), 8)};
+    return _mm_packs_epi32(lo, hi);
+}
+
+// Sums of 2x2 pixels of 16 columns of a row pair as 8 16-bit values.
+inline __m128i quadSumsSSE2(__m128i a, __m128i b) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i ONE{_mm_set1_epi16(1)};
+    const __m128i lo{_mm_madd_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, ZERO), _mm_unpacklo_epi8(b, ZERO)), ONE)};
+    const __m128i hi{_mm_madd_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, ZERO), _mm_unpackhi_epi8(b, ZERO)), ONE)};
+    return _mm_packs_epi32(lo, hi);
+}
+
+inline __m128i chromaSSE2(__m128i r, __m128i g, __m128i b, int32_t rg, int32_t b1) noexcept {
+    const __m128i RG{_mm_set1_epi32(rg)};
+    const __m128i B1{_mm_set1_epi32(b1)};
+    const __m128i ONE{_mm_set1_epi16(1)};
+    const __m128i BIAS{_mm_set1_epi32(UV_BIAS)};
+    const __m128i lo{_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), RG), _mm_madd_epi16(_mm_unpacklo_epi16(b, ONE), B1)), BIAS), 10)};
+    const __m128i hi{_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), RG), _mm_madd_epi16(_mm_unpackhi_epi16(b, ONE), B1)), BIAS), 10)};
+    return _mm_packs_epi32(lo, hi);
+}
+
+inline void storeRowSSE2(__m128i r, __m128i g, __m128i b, uint8_t *y, uint8_t *argb) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i lo{lumaSSE2(_mm_unpacklo_epi8(r, ZERO), _mm_unpacklo_epi8(g, ZERO), _mm_unpacklo_epi8(b, ZERO))};
+    const __m128i hi{lumaSSE2(_mm_unpackhi_epi8(r, ZERO), _mm_unpackhi_epi8(g, ZERO), _mm_unpackhi_epi8(b, ZERO))};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(y), _mm_packus_epi16(lo, hi));
+    if (nullptr != argb) {
+        const __m128i ALPHA{_mm_set1_epi8(static_cast<char>(0xFF))};
+        const __m128i bgLo{_mm_unpacklo_epi8(b, g)};
+        const __m128i bgHi{_mm_unpackhi_epi8(b, g)};
+        const __m128i raLo{_mm_unpacklo_epi8(r, ALPHA)};
+        const __m128i raHi{_mm_unpackhi_epi8(r, ALPHA)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(argb), _mm_unpacklo_epi16(bgLo, raLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(argb + 16), _mm_unpackhi_epi16(bgLo, raLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(argb + 32), _mm_unpacklo_epi16(bgHi, raHi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(argb + 48), _mm_unpackhi_epi16(bgHi, raHi));
+    }
+}
+
+uint32_t rgbRowPairSSE2(const uint8_t *r0, const uint8_t *g0, const uint8_t *b0, const uint8_t *r1, const uint8_t *g1, const uint8_t *b1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t width) noexcept {
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i R0{loadSSE2(r0 + x)};
+        const __m128i G0{loadSSE2(g0 + x)};
+        const __m128i B0{loadSSE2(b0 + x)};
+        const __m128i R1{loadSSE2(r1 + x)};
+        const __m128i G1{loadSSE2(g1 + x)};
+        const __m128i B1{loadSSE2(b1 + x)};
+        storeRowSSE2(R0, G0, B0, y0 + x, (nullptr != argb0) ? argb0 + 4 * x : nullptr);
+        storeRowSSE2(R1, G1, B1, y1 + x, (nullptr != argb1) ? argb1 + 4 * x : nullptr);
+
+        const __m128i r{quadSumsSSE2(R0, R1)};
+        const __m128i g{quadSumsSSE2(G0, G1)};
+        const __m128i b{quadSumsSSE2(B0, B1)};
+        const __m128i uv{_mm_packus_epi16(chromaSSE2(r, g, b, factorPair(RU, GU), factorPair(BU, UV_ROUND)),
+                                          chromaSSE2(r, g, b, factorPair(RV, GV), factorPair(BV, UV_ROUND)))};
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x / 2), uv);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x / 2), _mm_srli_si128(uv, 8));
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i loadAVX2(const uint8_t *p) noexcept {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__attribute__((target("avx2")))
+inline __m256i selectAVX2(__m256i mask, __m256i a, __m256i b) noexcept {
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+__attribute__((target("avx2")))
+inline __m256i parityMaskAVX2(uint32_t parity) noexcept {
+    return _mm256_set1_epi16((0 == parity) ? 0x00FF : static_cast<int16_t>(0xFF00));
+}
+
+__attribute__((target("avx2")))
+uint32_t bilinearRowAVX2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint32_t parity, uint8_t *own, uint8_t *green, uint8_t *other, uint32_t width) noexcept {
+    const __m256i MASK{parityMaskAVX2(parity)};
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i c{loadAVX2(mid + x)};
+        const __m256i h{_mm256_avg_epu8(loadAVX2(mid + x - 1), loadAVX2(mid + x + 1))};
+        const __m256i v{_mm256_avg_epu8(loadAVX2(up + x), loadAVX2(down + x))};
+        const __m256i d{_mm256_avg_epu8(_mm256_avg_epu8(loadAVX2(up + x - 1), loadAVX2(up + x + 1)), _mm256_avg_epu8(loadAVX2(down + x - 1), loadAVX2(down + x + 1)))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(own + x), selectAVX2(MASK, c, h));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(green + x), selectAVX2(MASK, _mm256_avg_epu8(h, v), c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(other + x), selectAVX2(MASK, d, v));
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i greenEstimateAVX2(__m256i m2, __m256i m1, __m256i c, __m256i p1, __m256i p2, __m256i u2, __m256i u1, __m256i d1, __m256i d2) noexcept {
+    const __m256i c2{_mm256_slli_epi16(c, 1)};
+    const __m256i lh{_mm256_sub_epi16(_mm256_sub_epi16(c2, m2), p2)};
+    const __m256i lv{_mm256_sub_epi16(_mm256_sub_epi16(c2, u2), d2)};
+    const __m256i gh{_mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(m1, p1)), _mm256_abs_epi16(lh))};
+    const __m256i gv{_mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(u1, d1)), _mm256_abs_epi16(lv))};
+    const __m256i eh{_mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_slli_epi16(_mm256_add_epi16(m1, p1), 1), lh), _mm256_set1_epi16(2)), 2)};
+    const __m256i ev{_mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_slli_epi16(_mm256_add_epi16(u1, d1), 1), lv), _mm256_set1_epi16(2)), 2)};
+    const __m256i mean{_mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(eh, ev), _mm256_set1_epi16(1)), 1)};
+    return selectAVX2(_mm256_cmpgt_epi16(gv, gh), eh, selectAVX2(_mm256_cmpgt_epi16(gh, gv), ev, mean));
+}
+
+__attribute__((target("avx2")))
+uint32_t greenRowAVX2(const uint8_t *up2, const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *down2, uint32_t parity, uint8_t *green, uint32_t width) noexcept {
+    const __m256i MASK{parityMaskAVX2(parity)};
+    const __m256i ZERO{_mm256_setzero_si256()};
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i m2{loadAVX2(mid + x - 2)};
+        const __m256i m1{loadAVX2(mid + x - 1)};
+        const __m256i c{loadAVX2(mid + x)};
+        const __m256i p1{loadAVX2(mid + x + 1)};
+        const __m256i p2{loadAVX2(mid + x + 2)};
+        const __m256i u2{loadAVX2(up2 + x)};
+        const __m256i u1{loadAVX2(up + x)};
+        const __m256i d1{loadAVX2(down + x)};
+        const __m256i d2{loadAVX2(down2 + x)};
+        // Unpacking and packing per 128-bit lane keeps the pixel order.
+        const __m256i lo{greenEstimateAVX2(_mm256_unpacklo_epi8(m2, ZERO), _mm256_unpacklo_epi8(m1, ZERO), _mm256_unpacklo_epi8(c, ZERO), _mm256_unpacklo_epi8(p1, ZERO), _mm256_unpacklo_epi8(p2, ZERO),
+                                           _mm256_unpacklo_epi8(u2, ZERO), _mm256_unpacklo_epi8(u1, ZERO), _mm256_unpacklo_epi8(d1, ZERO), _mm256_unpacklo_epi8(d2, ZERO))};
+        const __m256i hi{greenEstimateAVX2(_mm256_unpackhi_epi8(m2, ZERO), _mm256_unpackhi_epi8(m1, ZERO), _mm256_unpackhi_epi8(c, ZERO), _mm256_unpackhi_epi8(p1, ZERO), _mm256_unpackhi_epi8(p2, ZERO),
+                                           _mm256_unpackhi_epi8(u2, ZERO), _mm256_unpackhi_epi8(u1, ZERO), _mm256_unpackhi_epi8(d1, ZERO), _mm256_unpackhi_epi8(d2, ZERO))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(green + x), selectAVX2(MASK, _mm256_packus_epi16(lo, hi), c));
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i addDifferenceAVX2(__m256i g, __m256i a, __m256i b) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i lo{_mm256_add_epi16(_mm256_unpacklo_epi8(g, ZERO), _mm256_sub_epi16(_mm256_unpacklo_epi8(a, ZERO), _mm256_unpacklo_epi8(b, ZERO)))};
+    const __m256i hi{_mm256_add_epi16(_mm256_unpackhi_epi8(g, ZERO), _mm256_sub_epi16(_mm256_unpackhi_epi8(a, ZERO), _mm256_unpackhi_epi8(b, ZERO)))};
+    return _mm256_packus_epi16(lo, hi);
+}
+
+__attribute__((target("avx2")))
+uint32_t colourRowAVX2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *gUp, const uint8_t *gMid, const uint8_t *gDown, uint32_t parity, uint8_t *own, uint8_t *other, uint32_t width) noexcept {
+    const __m256i MASK{parityMaskAVX2(parity)};
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i g{loadAVX2(gMid + x)};
+        const __m256i hr{_mm256_avg_epu8(loadAVX2(mid + x - 1), loadAVX2(mid + x + 1))};
+        const __m256i hg{_mm256_avg_epu8(loadAVX2(gMid + x - 1), loadAVX2(gMid + x + 1))};
+        const __m256i vr{_mm256_avg_epu8(loadAVX2(up + x), loadAVX2(down + x))};
+        const __m256i vg{_mm256_avg_epu8(loadAVX2(gUp + x), loadAVX2(gDown + x))};
+        const __m256i dr{_mm256_avg_epu8(_mm256_avg_epu8(loadAVX2(up + x - 1), loadAVX2(up + x + 1)), _mm256_avg_epu8(loadAVX2(down + x - 1), loadAVX2(down + x + 1)))};
+        const __m256i dg{_mm256_avg_epu8(_mm256_avg_epu8(loadAVX2(gUp + x - 1), loadAVX2(gUp + x + 1)), _mm256_avg_epu8(loadAVX2(gDown + x - 1), loadAVX2(gDown + x + 1)))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(own + x), selectAVX2(MASK, loadAVX2(mid + x), addDifferenceAVX2(g, hr, hg)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(other + x), selectAVX2(MASK, addDifferenceAVX2(g, dr, dg), addDifferenceAVX2(g, vr, vg)));
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i lumaAVX2(__m256i r, __m256i g, __m256i b) noexcept {
+    const __m256i RG{_mm256_set1_epi32(factorPair(RY, GY))};
+    const __m256i B1{_mm256_set1_epi32(factorPair(BY, Y_BIAS))};
+    const __m256i ONE{_mm256_set1_epi16(1)};
+    const __m256i lo{_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r, g), RG), _mm256_madd_epi16(_mm256_unpacklo_epi16(b, ONE), B1)), 8)};
+    const __m256i hi{_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r, g), RG), _mm256_madd_epi16(_mm256_unpackhi_epi16(b, ONE), B1)), 8)};
+    return _mm256_packs_epi32(lo, hi);
+}
+
+__attribute__((target("avx2")))
+inline __m256i quadSumsAVX2(__m256i a, __m256i b) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i ONE{_mm256_set1_epi16(1)};
+    const __m256i lo{_mm256_madd_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, ZERO), _mm256_unpacklo_epi8(b, ZERO)), ONE)};
+    const __m256i hi{_mm256_madd_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, ZERO), _mm256_unpackhi_epi8(b, ZERO)), ONE)};
+    return _mm256_packs_epi32(lo, hi);
+}
+
+__attribute__((target("avx2")))
+inline __m256i chromaAVX2(__m256i r, __m256i g, __m256i b, int32_t rg, int32_t b1) noexcept {
+    const __m256i RG{_mm256_set1_epi32(rg)};
+    const __m256i B1{_mm256_set1_epi32(b1)};
+    const __m256i ONE{_mm256_set1_epi16(1)};
+    const __m256i BIAS{_mm256_set1_epi32(UV_BIAS)};
+    const __m256i lo{_mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r, g), RG), _mm256_madd_epi16(_mm256_unpacklo_epi16(b, ONE), B1)), BIAS), 10)};
+    const __m256i hi{_mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r, g), RG), _mm256_madd_epi16(_mm256_unpackhi_epi16(b, ONE), B1)), BIAS), 10)};
+    return _mm256_packs_epi32(lo, hi);
+}
+
+__attribute__((target("avx2")))
+inline void storeRowAVX2(__m256i r, __m256i g, __m256i b, uint8_t *y, uint8_t *argb) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i lo{lumaAVX2(_mm256_unpacklo_epi8(r, ZERO), _mm256_unpacklo_epi8(g, ZERO), _mm256_unpacklo_epi8(b, ZERO))};
+    const __m256i hi{lumaAVX2(_mm256_unpackhi_epi8(r, ZERO), _mm256_unpackhi_epi8(g, ZERO), _mm256_unpackhi_epi8(b, ZERO))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(y), _mm256_packus_epi16(lo, hi));
+    if (nullptr != argb) {
+        const __m256i ALPHA{_mm256_set1_epi8(static_cast<char>(0xFF))};
+        const __m256i bgLo{_mm256_unpacklo_epi8(b, g)};
+        const __m256i bgHi{_mm256_unpackhi_epi8(b, g)};
+        const __m256i raLo{_mm256_unpacklo_epi8(r, ALPHA)};
+        const __m256i raHi{_mm256_unpackhi_epi8(r, ALPHA)};
+        // Unpacking works per 128-bit lane; restore the pixel order afterwards.
+        const __m256i p0{_mm256_unpacklo_epi16(bgLo, raLo)};
+        const __m256i p1{_mm256_unpackhi_epi16(bgLo, raLo)};
+        const __m256i p2{_mm256_unpacklo_epi16(bgHi, raHi)};
+        const __m256i p3{_mm256_unpackhi_epi16(bgHi, raHi)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb), _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb + 64), _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(argb + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+}
+
+__attribute__((target("avx2")))
+uint32_t rgbRowPairAVX2(const uint8_t *r0, const uint8_t *g0, const uint8_t *b0, const uint8_t *r1, const uint8_t *g1, const uint8_t *b1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t width) noexcept {
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i R0{loadAVX2(r0 + x)};
+        const __m256i G0{loadAVX2(g0 + x)};
+        const __m256i B0{loadAVX2(b0 + x)};
+        const __m256i R1{loadAVX2(r1 + x)};
+        const __m256i G1{loadAVX2(g1 + x)};
+        const __m256i B1{loadAVX2(b1 + x)};
+        storeRowAVX2(R0, G0, B0, y0 + x, (nullptr != argb0) ? argb0 + 4 * x : nullptr);
+        storeRowAVX2(R1, G1, B1, y1 + x, (nullptr != argb1) ? argb1 + 4 * x : nullptr);
+
+        const __m256i r{quadSumsAVX2(R0, R1)};
+        const __m256i g{quadSumsAVX2(G0, G1)};
+        const __m256i b{quadSumsAVX2(B0, B1)};
+        const __m256i uv{_mm256_permute4x64_epi64(_mm256_packus_epi16(chromaAVX2(r, g, b, factorPair(RU, GU), factorPair(BU, UV_ROUND)),
+                                                                      chromaAVX2(r, g, b, factorPair(RV, GV), factorPair(BV, UV_ROUND))), 0xD8)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + x / 2), _mm256_castsi256_si128(uv));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x / 2), _mm256_extracti128_si256(uv, 1));
+    }
+    return x;
+}
+#endif
+
+void bilinearRow(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint32_t parity, uint8_t *own, uint8_t *green, uint8_t *other, uint32_t width) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    if (Isa::AVX2 == isa()) {
+        done = bilinearRowAVX2(up, mid, down, parity, own, green, other, width);
+    } else if (Isa::SSE2 == isa()) {
+        done = bilinearRowSSE2(up, mid, down, parity, own, green, other, width);
+    }
+#endif
+    bilinearRowScalar(up, mid, down, parity, own, green, other, done, width);
+}
+
+void greenRow(const uint8_t *up2, const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *down2, uint32_t parity, uint8_t *green, uint32_t width) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    if (Isa::AVX2 == isa()) {
+        done = greenRowAVX2(up2, up, mid, down, down2, parity, green, width);
+    } else if (Isa::SSE2 == isa()) {
+        done = greenRowSSE2(up2, up, mid, down, down2, parity, green, width);
+    }
+#endif
+    greenRowScalar(up2, up, mid, down, down2, parity, green, done, width);
+}
+
+void colourRow(const uint8_t *up, const uint8_t *mid, const uint8_t *down, const uint8_t *gUp, const uint8_t *gMid, const uint8_t *gDown, uint32_t parity, uint8_t *own, uint8_t *other, uint32_t width) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    if (Isa::AVX2 == isa()) {
+        done = colourRowAVX2(up, mid, down, gUp, gMid, gDown, parity, own, other, width);
+    } else if (Isa::SSE2 == isa()) {
+        done = colourRowSSE2(up, mid, down, gUp, gMid, gDown, parity, own, other, width);
+    }
+#endif
+    colourRowScalar(up, mid, down, gUp, gMid, gDown, parity, own, other, done, width);
+}
+
+void rgbRowPair(const uint8_t *r0, const uint8_t *g0, const uint8_t *b0, const uint8_t *r1, const uint8_t *g1, const uint8_t *b1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uint8_t *argb0, uint8_t *argb1, uint32_t width) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    if (Isa::AVX2 == isa()) {
+        done = rgbRowPairAVX2(r0, g0, b0, r1, g1, b1, y0, y1, u, v, argb0, argb1, width);
+    } else if (Isa::SSE2 == isa()) {
+        done = rgbRowPairSSE2(r0, g0, b0, r1, g1, b1, y0, y1, u, v, argb0, argb1, width);
+    }
+#endif
+    rgbRowPairScalar(r0, g0, b0, r1, g1, b1, y0, y1, u, v, argb0, argb1, done, width);
+}
+
+void unpack12pScalar(const uint8_t *src, uint16_t *dst, uint32_t first, uint32_t count) noexcept {
+    for (uint32_t x{first}; x + 1 < count; x += 2) {
+        const uint8_t *p{src + 3 * x / 2};
+        dst[x]     = static_cast<uint16_t>((p[0] << 4) | ((p[1] & 0x0F) << 12));
+        dst[x + 1] = static_cast<uint16_t>((p[1] & 0xF0) | (p[2] << 8));
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Unpacks 16 pixels per iteration, 8 per 128-bit lane; returns the number of pixels processed.
+__attribute__((target("avx2")))
+uint32_t unpack12pAVX2(const uint8_t *src, uint16_t *dst, uint32_t count) noexcept {
+    // Each pixel pair b0 b1 b2 becomes the 16-bit words b0|b1<<8 and b1|b2<<8.
+    const __m256i SPREAD{_mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                                          0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11)};
+    const __m256i EVEN{_mm256_set1_epi32(0x0000FFFF)};
+    const __m256i HIGH{_mm256_set1_epi16(static_cast<int16_t>(0xFFF0))};
+    uint32_t x{0};
+    // The second lane loads 16 bytes of which only 12 are used.
+    for (; 3 * x / 2 + 28 <= 3 * count / 2; x += 16) {
+        const uint8_t *p{src + 3 * x / 2};
+        const __m256i packed{_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 12)), 1)};
+        const __m256i words{_mm256_shuffle_epi8(packed, SPREAD)};
+        const __m256i left{_mm256_blendv_epi8(_mm256_and_si256(words, HIGH), _mm256_slli_epi16(words, 4), EVEN)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), left);
+    }
+    return x;
+}
+#endif
+
+void planarRowScalar(const uint8_t *argb, uint8_t *r, uint8_t *g, uint8_t *b, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        b[x] = argb[4 * x];
+        g[x] = argb[4 * x + 1];
+        r[x] = argb[4 * x + 2];
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Bytes at the given shift of 16 ARGB pixels.
+inline __m128i channelSSE2(const __m128i *p, int shift) noexcept {
+    const __m128i MASK{_mm_set1_epi32(0xFF)};
+    const __m128i a0{_mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m128i a1{_mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 1), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m128i a2{_mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 2), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m128i a3{_mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 3), _mm_cvtsi32_si128(shift)), MASK)};
+    return _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+}
+
+// Splits 16 pixels per iteration; returns the number of pixels processed.
+uint32_t planarRowSSE2(const uint8_t *argb, uint8_t *r, uint8_t *g, uint8_t *b, uint32_t width) noexcept {
+    uint32_t x{0};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i *p{reinterpret_cast<const __m128i *>(argb + 4 * x)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(b + x), channelSSE2(p, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(g + x), channelSSE2(p, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(r + x), channelSSE2(p, 16));
+    }
+    return x;
+}
+
+// Bytes at the given shift of 32 ARGB pixels.
+__attribute__((target("avx2")))
+inline __m256i channelAVX2(const __m256i *p, int shift) noexcept {
+    const __m256i MASK{_mm256_set1_epi32(0xFF)};
+    // The packs interleave the 128-bit lanes; the permutation restores the pixel order.
+    const __m256i ORDER{_mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)};
+    const __m256i a0{_mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m256i a1{_mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 1), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m256i a2{_mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 2), _mm_cvtsi32_si128(shift)), MASK)};
+    const __m256i a3{_mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 3), _mm_cvtsi32_si128(shift)), MASK)};
+    return _mm256_permutevar8x32_epi32(_mm256_packus_epi16(_mm256_packs_epi32(a0, a1), _mm256_packs_epi32(a2, a3)), ORDER);
+}
+
+// Splits 32 pixels per iteration; returns the number of pixels processed.
+__attribute__((target("avx2")))
+uint32_t planarRowAVX2(const uint8_t *argb, uint8_t *r, uint8_t *g, uint8_t *b, uint32_t width) noexcept {
+    uint32_t x{0};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i *p{reinterpret_cast<const __m256i *>(argb + 4 * x)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(b + x), channelAVX2(p, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(g + x), channelAVX2(p, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + x), channelAVX2(p, 16));
+    }
+    return x;
+}
+#endif
+
+// Rounds to the nearest half precision value, ties to even, as F16C does.
+inline uint16_t toHalf(float value) noexcept {
+    constexpr uint32_t INFINITE{255u << 23};
+    constexpr uint32_t HALF_OVERFLOW{(127u + 16u) << 23};
+    constexpr uint32_t HALF_NORMAL{113u << 23};
+    // Adding this float shifts a subnormal half's mantissa into the low bits.
+    constexpr uint32_t SUBNORMAL_MAGIC{((127u - 15u) + (23u - 10u) + 1u) << 23};
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    const uint32_t SIGN{f & 0x80000000u};
+    f ^= SIGN;
+    uint32_t h;
+    if (f >= HALF_OVERFLOW) {
+        h = (f > INFINITE) ? 0x7E00u : 0x7C00u;
+    } else if (f < HALF_NORMAL) {
+        float a, magic;
+        std::memcpy(&a, &f, sizeof(a));
+        std::memcpy(&magic, &SUBNORMAL_MAGIC, sizeof(magic));
+        a += magic;
+        std::memcpy(&h, &a, sizeof(h));
+        h -= SUBNORMAL_MAGIC;
+    } else {
+        const uint32_t ODD{(f >> 13) & 1u};
+        h = (f + 0xC8000FFFu + ODD) >> 13;
+    }
+    return static_cast<uint16_t>(h | (SIGN >> 16));
+}
+
+void tensorRowScalar(const uint8_t *argb, uint32_t channel, TensorType type, float scale, float bias, uint8_t *dst, uint32_t first, uint32_t width) noexcept {
+    for (uint32_t x{first}; x < width; x++) {
+        const uint8_t VALUE{argb[4 * x + channel]};
+        if (TensorType::UINT8 == type) {
+            dst[x] = VALUE;
+        } else if (TensorType::FLOAT16 == type) {
+            reinterpret_cast<uint16_t *>(dst)[x] = toHalf(static_cast<float>(VALUE) * scale + bias);
+        } else {
+            reinterpret_cast<float *>(dst)[x] = static_cast<float>(VALUE) * scale + bias;
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Writes one channel of 16 (UINT8) or 4 (FLOAT32) pixels per iteration; returns the number of pixels processed.
+uint32_t tensorRowSSE2(const uint8_t *argb, uint32_t channel, TensorType type, float scale, float bias, uint8_t *dst, uint32_t width) noexcept {
+    uint32_t x{0};
+    if (TensorType::UINT8 == type) {
+        for (; x + 16 <= width; x += 16) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), channelSSE2(reinterpret_cast<const __m128i *>(argb + 4 * x), static_cast<int>(8 * channel)));
+        }
+    } else if (TensorType::FLOAT32 == type) {
+        const __m128i MASK{_mm_set1_epi32(0xFF)};
+        const __m128 SCALE{_mm_set1_ps(scale)};
+        const __m128 BIAS{_mm_set1_ps(bias)};
+        for (; x + 4 <= width; x += 4) {
+            const __m128i pixels{_mm_loadu_si128(reinterpret_cast<const __m128i *>(argb + 4 * x))};
+            const __m128 values{_mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(static_cast<int>(8 * channel))), MASK))};
+            _mm_storeu_ps(reinterpret_cast<float *>(dst) + x, _mm_add_ps(_mm_mul_ps(values, SCALE), BIAS));
+        }
+    }
+    return x;
+}
+
+// Writes one channel of 32 (UINT8) or 8 (FLOAT32, FLOAT16) pixels per iteration; returns the number of pixels processed.
+__attribute__((target("avx2,f16c")))
+uint32_t tensorRowAVX2(const uint8_t *argb, uint32_t channel, TensorType type, float scale, float bias, uint8_t *dst, uint32_t width) noexcept {
+    uint32_t x{0};
+    if (TensorType::UINT8 == type) {
+        for (; x + 32 <= width; x += 32) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), channelAVX2(reinterpret_cast<const __m256i *>(argb + 4 * x), static_cast<int>(8 * channel)));
+        }
+        return x;
+    }
+    const __m256i MASK{_mm256_set1_epi32(0xFF)};
+    const __m128i SHIFT{_mm_cvtsi32_si128(static_cast<int>(8 * channel))};
+    const __m256 SCALE{_mm256_set1_ps(scale)};
+    const __m256 BIAS{_mm256_set1_ps(bias)};
+    const bool HALF{TensorType::FLOAT16 == type};
+    if (HALF && !hasF16C()) {
+        return x;
+    }
+    for (; x + 8 <= width; x += 8) {
+        const __m256i pixels{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(argb + 4 * x))};
+        const __m256 values{_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(pixels, SHIFT), MASK)), SCALE), BIAS)};
+        if (HALF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(reinterpret_cast<uint16_t *>(dst) + x), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+        } else {
+            _mm256_storeu_ps(reinterpret_cast<float *>(dst) + x, values);
+        }
+    }
+    return x;
+}
+#endif
+
+void halveRowScalar(const uint8_t *src0, const uint8_t *src1, uint8_t *dst, uint32_t first, uint32_t count, uint32_t bytesPerPixel) noexcept {
+    for (uint32_t i{first}; i < count; i++) {
+        // Byte i of the destination row averages bytes j and j + bytesPerPixel of both source rows.
+        const uint32_t j{(i / bytesPerPixel) * 2 * bytesPerPixel + i % bytesPerPixel};
+        dst[i] = static_cast<uint8_t>((src0[j] + src0[j + bytesPerPixel] + src1[j] + src1[j + bytesPerPixel] + 2) >> 2);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Sums of horizontally adjacent samples of 16 source bytes of both rows as 8 16-bit values.
+inline __m128i pairSumsSSE2(const uint8_t *src0, const uint8_t *src1, uint32_t bytesPerPixel) noexcept {
+    const __m128i a{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src0))};
+    const __m128i b{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src1))};
+    if (1 == bytesPerPixel) {
+        const __m128i EVEN{_mm_set1_epi16(0x00FF)};
+        return _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, EVEN), _mm_srli_epi16(a, 8)), _mm_add_epi16(_mm_and_si128(b, EVEN), _mm_srli_epi16(b, 8)));
+    }
+    // Four bytes per pixel: the low and high halves of the widened pixel pairs are added.
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i column{_mm_add_epi16(_mm_unpacklo_epi8(a, ZERO), _mm_unpacklo_epi8(b, ZERO))};
+    const __m128i next{_mm_add_epi16(_mm_unpackhi_epi8(a, ZERO), _mm_unpackhi_epi8(b, ZERO))};
+    return _mm_add_epi16(_mm_unpacklo_epi64(column, next), _mm_unpackhi_epi64(column, next));
+}
+
+// Halves 16 destination bytes per iteration; returns the number of bytes processed.
+uint32_t halveRowSSE2(const uint8_t *src0, const uint8_t *src1, uint8_t *dst, uint32_t count, uint32_t bytesPerPixel) noexcept {
+    const __m128i TWO{_mm_set1_epi16(2)};
+    uint32_t i{0};
+    for (; i + 16 <= count; i += 16) {
+        const __m128i lo{_mm_srli_epi16(_mm_add_epi16(pairSumsSSE2(src0 + 2 * i, src1 + 2 * i, bytesPerPixel), TWO), 2)};
+        const __m128i hi{_mm_srli_epi16(_mm_add_epi16(pairSumsSSE2(src0 + 2 * i + 16, src1 + 2 * i + 16, bytesPerPixel), TWO), 2)};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+// Sums of horizontally adjacent samples of 32 source bytes of both rows as 16 16-bit values, 8 per lane.
+__attribute__((target("avx2")))
+inline __m256i pairSumsAVX2(const uint8_t *src0, const uint8_t *src1, uint32_t bytesPerPixel) noexcept {
+    const __m256i a{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src0))};
+    const __m256i b{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src1))};
+    if (1 == bytesPerPixel) {
+        const __m256i EVEN{_mm256_set1_epi16(0x00FF)};
+        return _mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(a, EVEN), _mm256_srli_epi16(a, 8)), _mm256_add_epi16(_mm256_and_si256(b, EVEN), _mm256_srli_epi16(b, 8)));
+    }
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i column{_mm256_add_epi16(_mm256_unpacklo_epi8(a, ZERO), _mm256_unpacklo_epi8(b, ZERO))};
+    const __m256i next{_mm256_add_epi16(_mm256_unpackhi_epi8(a, ZERO), _mm256_unpackhi_epi8(b, ZERO))};
+    return _mm256_add_epi16(_mm256_unpacklo_epi64(column, next), _mm256_unpackhi_epi64(column, next));
+}
+
+// Halves 32 destination bytes per iteration; returns the number of bytes processed.
+__attribute__((target("avx2")))
+uint32_t halveRowAVX2(const uint8_t *src0, const uint8_t *src1, uint8_t *dst, uint32_t count, uint32_t bytesPerPixel) noexcept {
+    const __m256i TWO{_mm256_set1_epi16(2)};
+    uint32_t i{0};
+    for (; i + 32 <= count; i += 32) {
+        const __m256i lo{_mm256_srli_epi16(_mm256_add_epi16(pairSumsAVX2(src0 + 2 * i, src1 + 2 * i, bytesPerPixel), TWO), 2)};
+        const __m256i hi{_mm256_srli_epi16(_mm256_add_epi16(pairSumsAVX2(src0 + 2 * i + 32, src1 + 2 * i + 32, bytesPerPixel), TWO), 2)};
+        // The pack interleaves the 128-bit lanes of both halves.
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8));
+    }
+    return i;
+}
+#endif
+
+void remapScalar(const uint8_t *src, uint32_t srcStride, uint8_t *dst, const uint32_t *offsets, const uint16_t *fractions, uint32_t first, uint32_t count, uint32_t bytesPerPixel, uint32_t border) noexcept {
+    constexpr uint32_t ONE{1u << REMAP_FRACTION_BITS};
+    constexpr uint32_t ROUND{1u << (2 * REMAP_FRACTION_BITS - 1)};
+    const uint32_t ROW{srcStride * bytesPerPixel};
+    for (uint32_t i{first}; i < count; i++) {
+        uint8_t *out{dst + i * bytesPerPixel};
+        if (REMAP_OUTSIDE == offsets[i]) {
+            for (uint32_t c{0}; c < bytesPerPixel; c++) {
+                out[c] = static_cast<uint8_t>(border >> (8 * c));
+            }
+            continue;
+        }
+        const uint32_t FX{fractions[i] & 0xFFu};
+        const uint32_t FY{static_cast<uint32_t>(fractions[i] >> 8)};
+        const uint8_t *p{src + offsets[i] * bytesPerPixel};
+        for (uint32_t c{0}; c < bytesPerPixel; c++) {
+            const uint32_t TOP{p[c] * (ONE - FX) + p[bytesPerPixel + c] * FX};
+            const uint32_t BOTTOM{p[ROW + c] * (ONE - FX) + p[ROW + bytesPerPixel + c] * FX};
+            out[c] = static_cast<uint8_t>((TOP * (ONE - FY) + BOTTOM * FY + ROUND) >> (2 * REMAP_FRACTION_BITS));
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+// Weighs interleaved upper and lower 16-bit channels of one pixel per lane by that pixel's row weights.
+__attribute__((target("avx2")))
+inline __m256i remapRowsAVX2(__m256i pairs, __m256i weights, __m256i round) noexcept {
+    return _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(pairs, weights), round), 2 * REMAP_FRACTION_BITS);
+}
+
+// Interpolates 8 pixels per iteration from four gathers of their 2x2 source
+// pixels; groups with pixels outside the source are left to the scalar code.
+// Returns the number of pixels processed.
+__attribute__((target("avx2")))
+uint32_t remapAVX2(const uint8_t *src, uint32_t srcStride, uint8_t *dst, const uint32_t *offsets, const uint16_t *fractions, uint32_t count, uint32_t bytesPerPixel, uint32_t border) noexcept {
+    const __m256i OUTSIDE{_mm256_set1_epi32(static_cast<int>(REMAP_OUTSIDE))};
+    const __m256i ONE{_mm256_set1_epi32(1 << REMAP_FRACTION_BITS)};
+    const __m256i ROUND{_mm256_set1_epi32(1 << (2 * REMAP_FRACTION_BITS - 1))};
+    const __m256i LOW_BYTE{_mm256_set1_epi32(0xFF)};
+    const __m256i SECOND_BYTE{_mm256_set1_epi32(0xFF00)};
+    const int *base{reinterpret_cast<const int *>(src)};
+    uint32_t x{0};
+    for (; x + 8 <= count; x += 8) {
+        const __m256i offset{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + x))};
+        if (0 != _mm256_movemask_epi8(_mm256_cmpeq_epi32(offset, OUTSIDE))) {
+            remapScalar(src, srcStride, dst, offsets, fractions, x, x + 8, bytesPerPixel, border);
+            continue;
+        }
+        const __m256i fraction{_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(fractions + x)))};
+        const __m256i fx{_mm256_and_si256(fraction, LOW_BYTE)};
+        const __m256i fy{_mm256_srli_epi32(fraction, 8)};
+        // Weights of the upper and lower source rows as pairs of 16-bit values.
+        const __m256i wy{_mm256_or_si256(_mm256_sub_epi32(ONE, fy), _mm256_slli_epi32(fy, 16))};
+        if (1 == bytesPerPixel) {
+            const __m256i wx{_mm256_or_si256(_mm256_sub_epi32(ONE, fx), _mm256_slli_epi32(fx, 16))};
+            // The lower pair is loaded from two bytes before it so that no load ends beyond the plane.
+            const __m256i upper{_mm256_i32gather_epi32(base, offset, 1)};
+            const __m256i lower{_mm256_srli_epi32(_mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(static_cast<int>(srcStride) - 2)), 1), 16)};
+            const __m256i top{_mm256_madd_epi16(_mm256_or_si256(_mm256_and_si256(upper, LOW_BYTE), _mm256_slli_epi32(_mm256_and_si256(upper, SECOND_BYTE), 8)), wx)};
+            const __m256i bottom{_mm256_madd_epi16(_mm256_or_si256(_mm256_and_si256(lower, LOW_BYTE), _mm256_slli_epi32(_mm256_and_si256(lower, SECOND_BYTE), 8)), wx)};
+            const __m256i value{_mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_or_si256(top, _mm256_slli_epi32(bottom, 16)), wy), ROUND), 2 * REMAP_FRACTION_BITS)};
+            const __m256i packed{_mm256_packus_epi16(_mm256_packs_epi32(value, value), _mm256_setzero_si256())};
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+            continue;
+        }
+        // Weights of the left and right source pixels as pairs of bytes, once per channel.
+        __m256i wx{_mm256_or_si256(_mm256_sub_epi32(ONE, fx), _mm256_slli_epi32(fx, 8))};
+        wx = _mm256_or_si256(wx, _mm256_slli_epi32(wx, 16));
+        const __m256i wxLo{_mm256_unpacklo_epi32(wx, wx)};
+        const __m256i wxHi{_mm256_unpackhi_epi32(wx, wx)};
+        const __m256i topLeft{_mm256_i32gather_epi32(base, offset, 4)};
+        const __m256i topRight{_mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(1)), 4)};
+        const __m256i bottomLeft{_mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(static_cast<int>(srcStride))), 4)};
+        const __m256i bottomRight{_mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(static_cast<int>(srcStride) + 1)), 4)};
+        // Pixels 0, 1 | 4, 5 and 2, 3 | 6, 7 of the lanes, as 16-bit channels.
+        const __m256i topLo{_mm256_maddubs_epi16(_mm256_unpacklo_epi8(topLeft, topRight), wxLo)};
+        const __m256i topHi{_mm256_maddubs_epi16(_mm256_unpackhi_epi8(topLeft, topRight), wxHi)};
+        const __m256i bottomLo{_mm256_maddubs_epi16(_mm256_unpacklo_epi8(bottomLeft, bottomRight), wxLo)};
+        const __m256i bottomHi{_mm256_maddubs_epi16(_mm256_unpackhi_epi8(bottomLeft, bottomRight), wxHi)};
+        const __m256i lo{_mm256_packs_epi32(remapRowsAVX2(_mm256_unpacklo_epi16(topLo, bottomLo), _mm256_shuffle_epi32(wy, 0x00), ROUND),
+                                            remapRowsAVX2(_mm256_unpackhi_epi16(topLo, bottomLo), _mm256_shuffle_epi32(wy, 0x55), ROUND))};
+        const __m256i hi{_mm256_packs_epi32(remapRowsAVX2(_mm256_unpacklo_epi16(topHi, bottomHi), _mm256_shuffle_epi32(wy, 0xAA), ROUND),
+                                            remapRowsAVX2(_mm256_unpackhi_epi16(topHi, bottomHi), _mm256_shuffle_epi32(wy, 0xFF), ROUND))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 4 * x), _mm256_packus_epi16(lo, hi));
+    }
+    return x;
+}
+#endif
+
+/**
+ * Mirror-padded raw and green lines of a Bayer frame, cached in rings of
+ * line buffers so that each line is prepared once per stripe. Lines beyond
+ * the frame are mirrored at its border, which preserves the Bayer phase.
+ */
+class BayerLines {
+   private:
+    BayerLines(const BayerLines &) = delete;
+    BayerLines(BayerLines &&)      = delete;
+    BayerLines &operator=(const BayerLines &) = delete;
+    BayerLines &operator=(BayerLines &&) = delete;
+
+   public:
+    BayerLines(const uint8_t *bayer, uint32_t stride, uint32_t redRow, uint32_t redColumn, uint32_t width, uint32_t height, uint8_t *scratch) noexcept
+        : m_bayer{bayer}
+        , m_stride{stride}
+        , m_redRow{redRow}
+        , m_redColumn{redColumn}
+        , m_width{width}
+        , m_height{height}
+        , m_lineStride{lineStride(width)}
+        , m_scratch{scratch}
+        , m_rawRows{}
+        , m_greenRows{} {
+        for (auto &row : m_rawRows) {
+            row = -1;
+        }
+        for (auto &row : m_greenRows) {
+            row = -1;
+        }
+    }
+
+   public:
+    // @return Column parity of the red or blue sites of a row.
+    uint32_t parity(int32_t row) const noexcept {
+        return isRedRow(row) ? m_redColumn : 1 - m_redColumn;
+    }
+
+    bool isRedRow(int32_t row) const noexcept {
+        return (static_cast<uint32_t>(row) & 1) == m_redRow;
+    }
+
+    // @return Pointer to column 0 of a padded raw line.
+    const uint8_t *raw(int32_t row) noexcept {
+        const int32_t ROW{mirror(row)};
+        uint8_t *line{m_scratch + (ROW % RAW_LINES) * m_lineStride + PAD};
+        if (ROW != m_rawRows[ROW % RAW_LINES]) {
+            const uint8_t *src{m_bayer + static_cast<uint32_t>(ROW) * m_stride};
+            std::memcpy(line, src, m_width);
+            line[-1]          = src[1];
+            line[-2]          = src[2];
+            line[m_width]     = src[m_width - 2];
+            line[m_width + 1] = src[m_width - 3];
+            m_rawRows[ROW % RAW_LINES] = ROW;
+        }
+        return line;
+    }
+
+    // @return Pointer to column 0 of a padded, edge-aware interpolated green line.
+    const uint8_t *green(int32_t row) noexcept {
+        const int32_t ROW{mirror(row)};
+        uint8_t *line{m_scratch + (RAW_LINES + ROW % GREEN_LINES) * m_lineStride + PAD};
+        if (ROW != m_greenRows[ROW % GREEN_LINES]) {
+            greenRow(raw(ROW - 2), raw(ROW - 1), raw(ROW), raw(ROW + 1), raw(ROW + 2), parity(ROW), line, m_width);
+            line[-1]      = line[1];
+            line[m_width] = line[m_width - 2];
+            m_greenRows[ROW % GREEN_LINES] = ROW;
+        }
+        return line;
+    }
+
+    // @return Pointer to one of the unpadded lines for the demosaiced colours.
+    uint8_t *rgb(uint32_t index) noexcept {
+        return m_scratch + (RAW_LINES + GREEN_LINES + index) * m_lineStride;
+    }
+
+   private:
+    int32_t mirror(int32_t row) const noexcept {
+        const int32_t LAST{static_cast<int32_t>(m_height) - 1};
+        const int32_t ROW{(row < 0) ? -row : ((row > LAST) ? 2 * LAST - row : row)};
+        return (ROW < 0) ? 0 : ((ROW > LAST) ? LAST : ROW);
+    }
+
+   private:
+    const uint8_t *m_bayer;
+    const uint32_t m_stride;
+    const uint32_t m_redRow;
+    const uint32_t m_redColumn;
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const uint32_t m_lineStride;
+    uint8_t *m_scratch;
+    int32_t m_rawRows[RAW_LINES];
+    int32_t m_greenRows[GREEN_LINES];
+};
+
+// Demosaics one row into the given red, green, and blue lines; returns the green line.
+const uint8_t *demosaicRow(BayerLines &lines, int32_t row, Demosaic demosaic, uint8_t *r, uint8_t *g, uint8_t *b, uint32_t width) noexcept {
+    const uint32_t PARITY{lines.parity(row)};
+    uint8_t *own{lines.isRedRow(row) ? r : b};
+    uint8_t *other{lines.isRedRow(row) ? b : r};
+    if (Demosaic::EDGE_AWARE == demosaic) {
+        const uint8_t *gUp{lines.green(row - 1)};
+        const uint8_t *gMid{lines.green(row)};
+        const uint8_t *gDown{lines.green(row + 1)};
+        colourRow(lines.raw(row - 1), lines.raw(row), lines.raw(row + 1), gUp, gMid, gDown, PARITY, own, other, width);
+        return gMid;
+    }
+    bilinearRow(lines.raw(row - 1), lines.raw(row), lines.raw(row + 1), PARITY, own, g, other, width);
+    return g;
+}
+
+} // namespace
+
+void uyvyToI420AndARGB(const uint8_t *uyvy, uint32_t uyvyStride,
+                       uint8_t *y, uint32_t yStride,
+                       uint8_t *u, uint32_t uStride,
+                       uint8_t *v, uint32_t vStride,
+                       uint8_t *argb, uint32_t argbStride,
+                       uint32_t width, uint32_t height) noexcept {
+    const Isa ISA{isa()};
+    for (uint32_t row{0}; row < height; row += 2) {
+        // An odd last row is paired with itself.
+        const uint32_t next{(row + 1 < height) ? row + 1 : row};
+        const uint8_t *src0{uyvy + row * uyvyStride};
+        const uint8_t *src1{uyvy + next * uyvyStride};
+        uint8_t *y0{y + row * yStride};
+        uint8_t *y1{y + next * yStride};
+        uint8_t *u0{u + (row / 2) * uStride};
+        uint8_t *v0{v + (row / 2) * vStride};
+        uint8_t *argb0{(nullptr != argb) ? argb + row * argbStride : nullptr};
+        uint8_t *argb1{(nullptr != argb) ? argb + next * argbStride : nullptr};
+
+        uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+        if (Isa::AVX2 == ISA) {
+            done = uyvyRowPairAVX2(src0, src1, y0, y1, u0, v0, argb0, argb1, width);
+        } else if (Isa::SSE2 == ISA) {
+            done = uyvyRowPairSSE2(src0, src1, y0, y1, u0, v0, argb0, argb1, width);
+        }
+#else
+        (void)ISA;
+#endif
+        uyvyRowPairScalar(src0, src1, y0, y1, u0, v0, argb0, argb1, done, width);
+    }
+}
+
+void greyToARGB(const uint8_t *y, uint32_t yStride,
+                uint8_t *argb, uint32_t argbStride,
+                uint32_t width, uint32_t height) noexcept {
+    const Isa ISA{isa()};
+    for (uint32_t row{0}; row < height; row++) {
+        const uint8_t *src{y + row * yStride};
+        uint8_t *dst{argb + row * argbStride};
+        uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+        if (Isa::AVX2 == ISA) {
+            done = greyRowAVX2(src, dst, width);
+        } else if (Isa::SSE2 == ISA) {
+            done = greyRowSSE2(src, dst, width);
+        }
+#else
+        (void)ISA;
+#endif
+        greyRowScalar(src, dst, done, width);
+    }
+}
+
+uint32_t bayerScratchSize(uint32_t width) noexcept {
+    return (RAW_LINES + GREEN_LINES + RGB_LINES) * lineStride(width);
+}
+
+void bayerToI420AndARGB(const uint8_t *bayer, uint32_t bayerStride, BayerPattern pattern, Demosaic demosaic,
+                        uint8_t *y, uint32_t yStride,
+                        uint8_t *u, uint32_t uStride,
+                        uint8_t *v, uint32_t vStride,
+                        uint8_t *argb, uint32_t argbStride,
+                        uint32_t width, uint32_t height,
+                        uint32_t first, uint32_t last,
+                        uint8_t *scratch) noexcept {
+    // Row and column parity of the red sites.
+    const uint32_t RED_ROW{((BayerPattern::GBRG == pattern) || (BayerPattern::BGGR == pattern)) ? 1u : 0u};
+    const uint32_t RED_COLUMN{((BayerPattern::GRBG == pattern) || (BayerPattern::BGGR == pattern)) ? 1u : 0u};
+    BayerLines lines{bayer, bayerStride, RED_ROW, RED_COLUMN, width, height, scratch};
+    for (uint32_t row{first}; row < last; row += 2) {
+        // An odd last row is paired with itself.
+        const uint32_t next{(row + 1 < height) ? row + 1 : row};
+        uint8_t *r0{lines.rgb(0)};
+        uint8_t *b0{lines.rgb(2)};
+        const uint8_t *g0{demosaicRow(lines, static_cast<int32_t>(row), demosaic, r0, lines.rgb(1), b0, width)};
+        uint8_t *r1{r0};
+        uint8_t *b1{b0};
+        const uint8_t *g1{g0};
+        if (next != row) {
+            r1 = lines.rgb(3);
+            b1 = lines.rgb(5);
+            g1 = demosaicRow(lines, static_cast<int32_t>(next), demosaic, r1, lines.rgb(4), b1, width);
+        }
+        rgbRowPair(r0, g0, b0, r1, g1, b1,
+                   y + row * yStride, y + next * yStride,
+                   u + (row / 2) * uStride, v + (row / 2) * vStride,
+                   (nullptr != argb) ? argb + row * argbStride : nullptr,
+                   (nullptr != argb) ? argb + next * argbStride : nullptr,
+                   width);
+    }
+}
+
+void unpack12p(const uint8_t *src, uint16_t *dst, uint32_t count) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    if (Isa::AVX2 == isa()) {
+        done = unpack12pAVX2(src, dst, count);
+    }
+#endif
+    unpack12pScalar(src, dst, done, count);
+}
+
+void argbToPlanarRGB(const uint8_t *argb, uint32_t argbStride,
+                     uint8_t *r, uint8_t *g, uint8_t *b, uint32_t planeStride,
+                     uint32_t width, uint32_t height) noexcept {
+    const Isa ISA{isa()};
+    for (uint32_t row{0}; row < height; row++) {
+        const uint8_t *src{argb + row * argbStride};
+        const uint32_t OFFSET{row * planeStride};
+        uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+        if (Isa::AVX2 == ISA) {
+            done = planarRowAVX2(src, r + OFFSET, g + OFFSET, b + OFFSET, width);
+        } else if (Isa::SSE2 == ISA) {
+            done = planarRowSSE2(src, r + OFFSET, g + OFFSET, b + OFFSET, width);
+        }
+#else
+        (void)ISA;
+#endif
+        planarRowScalar(src, r + OFFSET, g + OFFSET, b + OFFSET, done, width);
+    }
+}
+
+uint32_t tensorElementSize(TensorType type) noexcept {
+    return (TensorType::FLOAT32 == type) ? 4 : ((TensorType::FLOAT16 == type) ? 2 : 1);
+}
+
+void argbToTensor(const uint8_t *argb, uint32_t argbStride,
+                  uint8_t *tensor, uint32_t rowStride, uint32_t planeStride,
+                  uint32_t width, uint32_t height, TensorType type,
+                  const uint32_t channels[3], const float scale[3], const float bias[3]) noexcept {
+    const Isa ISA{isa()};
+    const uint32_t ELEMENT_SIZE{tensorElementSize(type)};
+    for (uint32_t row{0}; row < height; row++) {
+        const uint8_t *src{argb + row * argbStride};
+        // A plane is written completely before the next one, so each output row is streamed.
+        for (uint32_t plane{0}; plane < 3; plane++) {
+            uint8_t *dst{tensor + (plane * planeStride + row * rowStride) * ELEMENT_SIZE};
+            uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+            if (Isa::AVX2 == ISA) {
+                done = tensorRowAVX2(src, channels[plane], type, scale[plane], bias[plane], dst, width);
+            } else if (Isa::SSE2 == ISA) {
+                done = tensorRowSSE2(src, channels[plane], type, scale[plane], bias[plane], dst, width);
+            }
+#else
+            (void)ISA;
+#endif
+            tensorRowScalar(src, channels[plane], type, scale[plane], bias[plane], dst, done, width);
+        }
+    }
+}
+
+void halve(const uint8_t *src, uint32_t srcStride,
+           uint8_t *dst, uint32_t dstStride,
+           uint32_t width, uint32_t height, uint32_t bytesPerPixel) noexcept {
+    const Isa ISA{isa()};
+    const uint32_t COUNT{width * bytesPerPixel};
+    for (uint32_t row{0}; row < height; row++) {
+        const uint8_t *src0{src + 2 * row * srcStride};
+        const uint8_t *src1{src0 + srcStride};
+        uint8_t *out{dst + row * dstStride};
+        uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+        if (Isa::AVX2 == ISA) {
+            done = halveRowAVX2(src0, src1, out, COUNT, bytesPerPixel);
+        } else if (Isa::SSE2 == ISA) {
+            done = halveRowSSE2(src0, src1, out, COUNT, bytesPerPixel);
+        }
+#else
+        (void)ISA;
+#endif
+        halveRowScalar(src0, src1, out, done, COUNT, bytesPerPixel);
+    }
+}
+
+void remap(const uint8_t *src, uint32_t srcStride, uint8_t *dst,
+           const uint32_t *offsets, const uint16_t *fractions,
+           uint32_t count, uint32_t bytesPerPixel, uint32_t border) noexcept {
+    uint32_t done{0};
+#ifdef HAVE_X86_KERNELS
+    // Without gathers, SSE2 would load the pixels one by one just as the scalar code does.
+    if (Isa::AVX2 == isa()) {
+        done = remapAVX2(src, srcStride, dst, offsets, fractions, count, bytesPerPixel, border);
+    }
+#endif
+    remapScalar(src, srcStride, dst, offsets, fractions, done, count, bytesPerPixel, border);
+}
+
+void toneMap(const uint16_t *src, const uint8_t *table, uint8_t *dst, uint32_t count) noexcept {
+    // The table fits into L1; gathers would not be faster than these loads.
+    for (uint32_t x{0}; x < count; x++) {
+        dst[x] = table[src[x] >> 4];
+    }
+}
+
+} // namespace kernels
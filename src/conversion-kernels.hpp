@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONVERSION_KERNELS_HPP
+#define CONVERSION_KERNELS_HPP
+
+#include <cstdint>
+
+/**
+ * Colour conversion kernels working directly on the camera's buffers.
+ *
+ * All kernels use BT.601 limited range coefficients, in 6-bit fixed point
+ * with saturating 16-bit arithmetic from YUV to RGB and in 8-bit fixed point
+ * with 32-bit sums from RGB to YUV. The SIMD variants (SSE2, AVX2) are
+ * selected at runtime and produce bit-identical results to the scalar code;
+ * unpacking 12-bit frames needs byte shuffles and hence AVX2.
+ */
+namespace kernels {
+
+// Colours of the top left 2x2 pixels of a Bayer frame.
+enum class BayerPattern { RGGB, GRBG, GBRG, BGGR };
+
+// BILINEAR averages the nearest sites of a colour; EDGE_AWARE interpolates
+// green along the smaller gradient (Hamilton-Adams) and red and blue as
+// differences to green, which avoids most zipper and colour fringe artefacts.
+enum class Demosaic { BILINEAR, EDGE_AWARE };
+
+// Element type of a tensor; FLOAT16 is stored as the bits of an IEEE half.
+enum class TensorType { FLOAT32, FLOAT16, UINT8 };
+
+// Fractional bits of the source positions of remap().
+constexpr uint32_t REMAP_FRACTION_BITS{6};
+// Source offset of destination pixels outside the source frame.
+constexpr uint32_t REMAP_OUTSIDE{0xFFFFFFFFu};
+
+/**
+ * This function converts a UYVY frame into I420 planes and, optionally,
+ * into ARGB in one pass: each pair of UYVY rows is read once, the chroma of
+ * both rows is averaged for the U and V planes, and the very same values
+ * are used to produce the two ARGB rows.
+ *
+ * @param uyvy Source frame.
+ * @param uyvyStride Bytes per source row.
+ * @param y Destination Y plane.
+ * @param yStride Bytes per Y row.
+ * @param u Destination U plane.
+ * @param uStride Bytes per U row.
+ * @param v Destination V plane.
+ * @param vStride Bytes per V row.
+ * @param argb Destination ARGB frame (B, G, R, A in memory); nullptr to skip.
+ * @param argbStride Bytes per ARGB row.
+ * @param width Width of the frame (even).
+ * @param height Height of the frame.
+ */
+void uyvyToI420AndARGB(const uint8_t *uyvy, uint32_t uyvyStride,
+                       uint8_t *y, uint32_t yStride,
+                       uint8_t *u, uint32_t uStride,
+                       uint8_t *v, uint32_t vStride,
+                       uint8_t *argb, uint32_t argbStride,
+                       uint32_t width, uint32_t height) noexcept;
+
+/**
+ * This function converts a grey (Y only) frame into ARGB as uyvyToI420AndARGB
+ * would with neutral chroma.
+ *
+ * @param y Source frame.
+ * @param yStride Bytes per source row.
+ * @param argb Destination ARGB frame (B, G, R, A in memory).
+ * @param argbStride Bytes per ARGB row.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ */
+void greyToARGB(const uint8_t *y, uint32_t yStride,
+                uint8_t *argb, uint32_t argbStride,
+                uint32_t width, uint32_t height) noexcept;
+
+/**
+ * @return Size in bytes of the scratch memory for bayerToI420AndARGB.
+ */
+uint32_t bayerScratchSize(uint32_t width) noexcept;
+
+/**
+ * This function demosaics the rows [first, last) of an 8-bit Bayer frame
+ * into I420 planes and, optionally, into ARGB in one pass. Rows outside of
+ * [first, last) are only read, so disjoint row ranges of one frame can be
+ * processed in parallel, each with its own scratch memory.
+ *
+ * @param bayer Source frame.
+ * @param bayerStride Bytes per source row.
+ * @param pattern Colour filter arrangement of the source frame.
+ * @param demosaic Interpolation method.
+ * @param y Destination Y plane of the whole frame.
+ * @param yStride Bytes per Y row.
+ * @param u Destination U plane of the whole frame.
+ * @param uStride Bytes per U row.
+ * @param v Destination V plane of the whole frame.
+ * @param vStride Bytes per V row.
+ * @param argb Destination ARGB frame (B, G, R, A in memory); nullptr to skip.
+ * @param argbStride Bytes per ARGB row.
+ * @param width Width of the frame (even, at least 4).
+ * @param height Height of the frame (at least 2).
+ * @param first First row to convert (even).
+ * @param last Row after the last row to convert.
+ * @param scratch Memory of bayerScratchSize(width) bytes.
+ */
+void bayerToI420AndARGB(const uint8_t *bayer, uint32_t bayerStride, BayerPattern pattern, Demosaic demosaic,
+                        uint8_t *y, uint32_t yStride,
+                        uint8_t *u, uint32_t uStride,
+                        uint8_t *v, uint32_t vStride,
+                        uint8_t *argb, uint32_t argbStride,
+                        uint32_t width, uint32_t height,
+                        uint32_t first, uint32_t last,
+                        uint8_t *scratch) noexcept;
+
+/**
+ * This function unpacks a row of GenICam 12p pixels (two pixels in three
+ * bytes, least significant bits first) into 16-bit values that are
+ * left-aligned, i.e., multiplied by 16.
+ *
+ * @param src Packed row.
+ * @param dst Unpacked row.
+ * @param count Number of pixels (even).
+ */
+void unpack12p(const uint8_t *src, uint16_t *dst, uint32_t count) noexcept;
+
+/**
+ * This function splits an ARGB frame into R, G, and B planes.
+ *
+ * @param argb Source frame (B, G, R, A in memory).
+ * @param argbStride Bytes per ARGB row.
+ * @param r Destination R plane.
+ * @param g Destination G plane.
+ * @param b Destination B plane.
+ * @param planeStride Bytes per row of a plane.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ */
+void argbToPlanarRGB(const uint8_t *argb, uint32_t argbStride,
+                     uint8_t *r, uint8_t *g, uint8_t *b, uint32_t planeStride,
+                     uint32_t width, uint32_t height) noexcept;
+
+/**
+ * @return Size in bytes of an element of the given type.
+ */
+uint32_t tensorElementSize(TensorType type) noexcept;
+
+/**
+ * This function writes ARGB pixels into the three planes of a CHW tensor.
+ * Element (plane, row, x) is the byte channels[plane] of the pixel (row, x)
+ * as is for UINT8 and multiplied by scale[plane] plus bias[plane] otherwise;
+ * FLOAT16 values are rounded to the nearest even half.
+ *
+ * @param argb Source frame (B, G, R, A in memory).
+ * @param argbStride Bytes per ARGB row.
+ * @param tensor First element of the first plane to write.
+ * @param rowStride Elements per tensor row.
+ * @param planeStride Elements per tensor plane.
+ * @param width Number of pixels per row.
+ * @param height Number of rows.
+ * @param type Element type.
+ * @param channels Byte offset within an ARGB pixel for each plane (0: B, 1: G, 2: R).
+ * @param scale Factor for each plane.
+ * @param bias Offset for each plane.
+ */
+void argbToTensor(const uint8_t *argb, uint32_t argbStride,
+                  uint8_t *tensor, uint32_t rowStride, uint32_t planeStride,
+                  uint32_t width, uint32_t height, TensorType type,
+                  const uint32_t channels[3], const float scale[3], const float bias[3]) noexcept;
+
+/**
+ * This function halves a plane or an ARGB frame in both dimensions; each
+ * destination sample is the rounded mean of a 2x2 box of source samples.
+ *
+ * @param src Source frame of 2 * width x 2 * height pixels.
+ * @param srcStride Bytes per source row.
+ * @param dst Destination frame.
+ * @param dstStride Bytes per destination row.
+ * @param width Width of the destination frame.
+ * @param height Height of the destination frame.
+ * @param bytesPerPixel 1 for a plane, 4 for ARGB.
+ */
+void halve(const uint8_t *src, uint32_t srcStride,
+           uint8_t *dst, uint32_t dstStride,
+           uint32_t width, uint32_t height, uint32_t bytesPerPixel) noexcept;
+
+/**
+ * This function interpolates pixels bilinearly at given source positions.
+ * Pixel i is interpolated from the 2x2 source pixels starting at pixel
+ * offsets[i] with the fractions of a pixel (in 1 / 2^REMAP_FRACTION_BITS)
+ * to the right in the low byte and downwards in the high byte of
+ * fractions[i]. All four pixels must lie within the source frame, even
+ * where a fraction is 0 or 1; pixels at REMAP_OUTSIDE get the border value.
+ *
+ * @param src Source frame.
+ * @param srcStride Pixels per source row.
+ * @param dst Destination pixels.
+ * @param offsets Source pixel of each destination pixel.
+ * @param fractions Source fractions of each destination pixel.
+ * @param count Number of destination pixels.
+ * @param bytesPerPixel 1 for a plane, 4 for ARGB.
+ * @param border Value of pixels outside the source, byte 0 first.
+ */
+void remap(const uint8_t *src, uint32_t srcStride, uint8_t *dst,
+           const uint32_t *offsets, const uint16_t *fractions,
+           uint32_t count, uint32_t bytesPerPixel, uint32_t border) noexcept;
+
+/**
+ * This function maps a row of left-aligned 16-bit values to 8 bits.
+ *
+ * @param src Row of 16-bit values.
+ * @param table 4096 entries indexed by the upper 12 bits of a value.
+ * @param dst Row of 8-bit values.
+ * @param count Number of pixels.
+ */
+void toneMap(const uint16_t *src, const uint8_t *table, uint8_t *dst, uint32_t count) noexcept;
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame-converter.hpp"
+#include "conversion-kernels.hpp"
+#include "tone-map.hpp"
+
+#include <libyuv.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+FrameConverter::PixelFormat narrowFormatOf(FrameConverter::PixelFormat pixelFormat) noexcept {
+    switch (pixelFormat) {
+        case FrameConverter::PixelFormat::MONO12P:
+        case FrameConverter::PixelFormat::MONO16: return FrameConverter::PixelFormat::MONO8;
+        case FrameConverter::PixelFormat::BAYER12P: return FrameConverter::PixelFormat::BAYER8;
+        default: return pixelFormat;
+    }
+}
+
+// Levels are built as long as the chroma planes of the level above halve exactly.
+uint32_t pyramidLevelsOf(uint32_t width, uint32_t height, uint32_t requested) noexcept {
+    uint32_t levels{0};
+    while ((levels < requested) && (levels < FrameConverter::MAX_PYRAMID_LEVELS) && (0 < width) && (0 < height) && (0 == width % 4) && (0 == height % 4)) {
+        width /= 2;
+        height /= 2;
+        levels++;
+    }
+    return levels;
+}
+
+// Crops are aligned to row and column pairs as I420 requires and limited to the frame.
+std::vector<FrameConverter::Crop> validCrops(uint32_t width, uint32_t height, const std::vector<FrameConverter::Crop> &crops) noexcept {
+    std::vector<FrameConverter::Crop> retVal;
+    for (auto crop : crops) {
+        crop.x &= ~1u;
+        crop.y &= ~1u;
+        crop.width  = (crop.x < width) ? (std::min(crop.width, width - crop.x) & ~1u) : 0;
+        crop.height = (crop.y < height) ? (std::min(crop.height, height - crop.y) & ~1u) : 0;
+        if ((0 == crop.width) || (0 == crop.height) || (FrameConverter::MAX_CROPS == retVal.size())) {
+            continue;
+        }
+        crop.outputWidth  = (0 < crop.outputWidth) ? (crop.outputWidth + 1) & ~1u : crop.width;
+        crop.outputHeight = (0 < crop.outputHeight) ? (crop.outputHeight + 1) & ~1u : crop.height;
+        retVal.push_back(crop);
+    }
+    return retVal;
+}
+
+FrameConverter::Tensor validTensor(FrameConverter::Tensor tensor) noexcept {
+    if ((0 == tensor.width) || (0 == tensor.height)) {
+        tensor.width  = 0;
+        tensor.height = 0;
+    }
+    for (uint32_t i{0}; i < 3; i++) {
+        tensor.std[i] = (0.0f < tensor.std[i]) ? tensor.std[i] : 1.0f;
+    }
+    return tensor;
+}
+} // namespace
+
+FrameConverter::FrameConverter(uint32_t width, uint32_t height, PixelFormat pixelFormat, kernels::BayerPattern bayerPattern, kernels::Demosaic demosaic, const std::vector<uint8_t> &toneMap, uint32_t pyramidLevels, const std::vector<Crop> &crops, const Tensor &tensor, const RemapTable::Calibration &calibration, WorkerPool &workerPool) noexcept
+    : m_width{width}
+    , m_height{height}
+    , m_pixelFormat{pixelFormat}
+    , m_narrowFormat{narrowFormatOf(pixelFormat)}
+    , m_bayerPattern{bayerPattern}
+    , m_demosaic{demosaic}
+    , m_toneMap{(ToneMap::SIZE == toneMap.size()) ? toneMap : ToneMap{ToneMap::Curve::LINEAR}.table()}
+    , m_pyramidLevels{pyramidLevelsOf(width, height, pyramidLevels)}
+    , m_crops{validCrops(width, height, crops)}
+    , m_tensor{validTensor(tensor)}
+    , m_workerPool{workerPool}
+    , m_scratch{}
+    , m_narrow{}
+    , m_i420{}
+    , m_argb{}
+    , m_cropI420{}
+    , m_cropARGB{}
+    , m_neutralChroma{}
+    , m_tensorARGB{}
+    , m_paddedTensors{}
+    , m_remapLuma{}
+    , m_remapChroma{} {
+    uint32_t scratchSize{0};
+    if (PixelFormat::BAYER8 == m_narrowFormat) {
+        scratchSize = kernels::bayerScratchSize(m_width);
+    }
+    if (isHighBitDepth()) {
+        scratchSize = std::max(scratchSize, m_width * static_cast<uint32_t>(sizeof(uint16_t)));
+        // Monochrome frames are tone mapped straight into the Y plane.
+        if (PixelFormat::BAYER8 == m_narrowFormat) {
+            m_narrow.resize(m_width * m_height);
+        }
+    }
+    if (0 < scratchSize) {
+        m_scratch.resize(m_workerPool.size(), std::vector<uint8_t>(scratchSize));
+    }
+    for (const auto &crop : m_crops) {
+        const bool RESAMPLE{(crop.outputWidth != crop.width) || (crop.outputHeight != crop.height)};
+        m_cropI420.emplace_back(RESAMPLE ? crop.width * crop.height * 3 / 2 : 0);
+        m_cropARGB.emplace_back(RESAMPLE ? crop.width * crop.height * 4 : 0);
+    }
+    if (0 < m_tensor.width) {
+        const uint32_t TW{m_tensor.width};
+        const uint32_t TH{m_tensor.height};
+        m_tensorWidth  = TW;
+        m_tensorHeight = TH;
+        if (m_tensor.letterbox) {
+            // The frame is scaled by the smaller ratio so that it fits as a whole.
+            if (static_cast<uint64_t>(TW) * m_height <= static_cast<uint64_t>(TH) * m_width) {
+                m_tensorHeight = std::max(1u, static_cast<uint32_t>((static_cast<uint64_t>(m_height) * TW + m_width / 2) / m_width));
+            } else {
+                m_tensorWidth = std::max(1u, static_cast<uint32_t>((static_cast<uint64_t>(m_width) * TH + m_height / 2) / m_height));
+            }
+        }
+        m_tensorLeft = (TW - m_tensorWidth) / 2;
+        m_tensorTop  = (TH - m_tensorHeight) / 2;
+        if ((m_tensorWidth != m_width) || (m_tensorHeight != m_height)) {
+            m_tensorARGB.resize(m_tensorWidth * m_tensorHeight * 4);
+        }
+    }
+    // The chroma planes have remap tables of their own at half the resolution.
+    if (calibration.valid() && (4 <= m_width) && (4 <= m_height)) {
+        m_remapLuma.reset(new RemapTable{calibration, m_width, m_height, 1});
+        m_remapChroma.reset(new RemapTable{calibration, m_width, m_height, 2});
+    }
+}
+
+bool FrameConverter::isHighBitDepth() const noexcept {
+    return (m_narrowFormat != m_pixelFormat);
+}
+
+uint32_t FrameConverter::pyramidLevels() const noexcept {
+    return m_pyramidLevels;
+}
+
+std::pair<uint32_t, uint32_t> FrameConverter::pyramidSize(uint32_t level) const noexcept {
+    return std::make_pair(m_width >> level, m_height >> level);
+}
+
+const std::vector<FrameConverter::Crop> &FrameConverter::crops() const noexcept {
+    return m_crops;
+}
+
+const FrameConverter::Tensor &FrameConverter::tensor() const noexcept {
+    return m_tensor;
+}
+
+uint32_t FrameConverter::tensorSize() const noexcept {
+    return m_tensor.width * m_tensor.height * 3 * kernels::tensorElementSize(m_tensor.type);
+}
+
+bool FrameConverter::canUndistort() const noexcept {
+    return (nullptr != m_remapLuma);
+}
+
+void FrameConverter::convert(const uint8_t *src, Destinations destinations) noexcept {
+    bool withCropI420{false};
+    bool withCropARGB{false};
+    for (uint32_t i{0}; i < m_crops.size(); i++) {
+        withCropI420 = withCropI420 || (nullptr != destinations.cropI420[i]);
+        withCropARGB = withCropARGB || (nullptr != destinations.cropARGB[i]);
+    }
+
+    // NV12 is derived from I420, the RGB formats and the tensor from ARGB; UYVY frames are copied.
+    const bool WITH_PYRAMID{(0 < m_pyramidLevels) && (nullptr != destinations.pyramidI420[0])};
+    const bool WITH_TENSOR{(0 < m_tensor.width) && (nullptr != destinations.tensor)};
+    const bool WITH_UNDISTORTED_I420{canUndistort() && (nullptr != destinations.undistortedI420)};
+    const bool WITH_UNDISTORTED_ARGB{canUndistort() && (nullptr != destinations.undistortedARGB)};
+    const bool WITH_ARGB{(nullptr != destinations.argb) || (nullptr != destinations.bgr24) || (nullptr != destinations.rgb24) || (nullptr != destinations.rgbPlanar) || (WITH_PYRAMID && (nullptr != destinations.pyramidARGB[0])) || withCropARGB || WITH_TENSOR || WITH_UNDISTORTED_ARGB};
+    const bool CONVERT{WITH_ARGB || WITH_PYRAMID || withCropI420 || WITH_UNDISTORTED_I420 || (nullptr != destinations.i420) || (nullptr != destinations.nv12)};
+    const bool COPY{(nullptr != destinations.uyvy) && (PixelFormat::UYVY == m_pixelFormat)};
+    if (!CONVERT && !COPY && (nullptr == destinations.wide)) {
+        return;
+    }
+    // Any colour format is derived along with an I420 frame, even if nobody reads it.
+    if (CONVERT && (nullptr == destinations.i420)) {
+        if (m_i420.empty()) {
+            m_i420.resize(m_width * m_height * 3 / 2);
+        }
+        destinations.i420 = m_i420.data();
+    }
+    if (WITH_ARGB && (nullptr == destinations.argb)) {
+        if (m_argb.empty()) {
+            m_argb.resize(m_width * m_height * 4);
+        }
+        destinations.argb = m_argb.data();
+    }
+    uint8_t *i420{destinations.i420};
+    uint16_t *wide{destinations.wide};
+
+    const uint32_t STRIPES{m_workerPool.size()};
+    if (isHighBitDepth()) {
+        uint8_t *narrow{!CONVERT ? nullptr : ((PixelFormat::MONO8 == m_narrowFormat) ? i420 : m_narrow.data())};
+        m_workerPool.parallelFor(STRIPES, [this, src, wide, narrow, STRIPES](uint32_t stripe) {
+            const auto ROWS{stripeRows(stripe, STRIPES, m_height)};
+            if (ROWS.first < ROWS.second) {
+                narrowStripe(src, wide, narrow, ROWS.first, ROWS.second, m_scratch[stripe].data());
+            }
+        });
+        src = narrow;
+    }
+    if (!CONVERT && !COPY) {
+        return;
+    }
+
+    // The chroma planes of monochrome frames are neutral; they are filled
+    // once per destination buffer instead of once per frame.
+    bool fillChroma{false};
+    if (CONVERT && (PixelFormat::MONO8 == m_narrowFormat) && (m_neutralChroma.end() == std::find(m_neutralChroma.begin(), m_neutralChroma.end(), i420))) {
+        m_neutralChroma.push_back(i420);
+        fillChroma = true;
+    }
+    m_workerPool.parallelFor(STRIPES, [this, src, &destinations, CONVERT, fillChroma, STRIPES](uint32_t stripe) {
+        const auto ROWS{stripeRows(stripe, STRIPES, m_height)};
+        if (ROWS.first < ROWS.second) {
+            if (CONVERT) {
+                convertStripe(src, destinations.i420, destinations.argb, ROWS.first, ROWS.second, m_scratch.empty() ? nullptr : m_scratch[stripe].data(), fillChroma);
+            }
+            deriveStripe(src, destinations, ROWS.first, ROWS.second);
+            if (CONVERT) {
+                cropStripe(destinations, ROWS.first, ROWS.second);
+            }
+        }
+    });
+    if (withCropI420 || withCropARGB) {
+        resampleCrops(destinations);
+    }
+    if (WITH_PYRAMID) {
+        buildPyramid(destinations);
+    }
+    if (WITH_TENSOR) {
+        buildTensor(destinations);
+    }
+    if (WITH_UNDISTORTED_I420 || WITH_UNDISTORTED_ARGB) {
+        undistort(destinations);
+    }
+}
+
+void FrameConverter::undistort(const Destinations &destinations) noexcept {
+    const uint32_t W{m_width};
+    const uint32_t H{m_height};
+    const uint32_t STRIPES{m_workerPool.size()};
+    m_workerPool.parallelFor(STRIPES, [this, &destinations, W, H, STRIPES](uint32_t stripe) {
+        // Rows of tiles are split evenly; the source rows of a stripe overlap the neighbouring ones.
+        const uint32_t LUMA_ROWS{m_remapLuma->tileRows()};
+        const uint32_t FIRST{static_cast<uint32_t>((static_cast<uint64_t>(LUMA_ROWS) * stripe) / STRIPES)};
+        const uint32_t LAST{static_cast<uint32_t>((static_cast<uint64_t>(LUMA_ROWS) * (stripe + 1)) / STRIPES)};
+        if (nullptr != destinations.undistortedI420) {
+            const uint32_t CHROMA_ROWS{m_remapChroma->tileRows()};
+            const uint32_t CHROMA_FIRST{static_cast<uint32_t>((static_cast<uint64_t>(CHROMA_ROWS) * stripe) / STRIPES)};
+            const uint32_t CHROMA_LAST{static_cast<uint32_t>((static_cast<uint64_t>(CHROMA_ROWS) * (stripe + 1)) / STRIPES)};
+            // Pixels outside the camera's view are black (BT.601 limited range: Y 16, U and V 128).
+            m_remapLuma->remap(destinations.i420, destinations.undistortedI420, 1, 16, FIRST, LAST);
+            for (uint32_t plane{0}; plane < 2; plane++) {
+                const uint32_t OFFSET{W * H + plane * ((W * H) >> 2)};
+                m_remapChroma->remap(destinations.i420 + OFFSET, destinations.undistortedI420 + OFFSET, 1, 128, CHROMA_FIRST, CHROMA_LAST);
+            }
+        }
+        if (nullptr != destinations.undistortedARGB) {
+            m_remapLuma->remap(destinations.argb, destinations.undistortedARGB, 4, 0xFF000000u, FIRST, LAST);
+        }
+    });
+}
+
+void FrameConverter::buildTensor(const Destinations &destinations) noexcept {
+    const uint32_t W{m_width};
+    const uint32_t H{m_height};
+    const uint32_t TW{m_tensor.width};
+    const uint32_t TH{m_tensor.height};
+    const uint32_t CW{m_tensorWidth};
+    const uint32_t CH{m_tensorHeight};
+    const kernels::TensorType TYPE{m_tensor.type};
+    const uint32_t ELEMENT_SIZE{kernels::tensorElementSize(TYPE)};
+
+    // Planes are taken from the bytes B (0), G (1), and R (2) of an ARGB pixel.
+    const uint32_t CHANNELS[3]{m_tensor.bgr ? 0u : 2u, 1u, m_tensor.bgr ? 2u : 0u};
+    float scale[3]{1.0f, 1.0f, 1.0f};
+    float bias[3]{0.0f, 0.0f, 0.0f};
+    if (kernels::TensorType::UINT8 != TYPE) {
+        for (uint32_t plane{0}; plane < 3; plane++) {
+            const uint32_t RGB{2 - CHANNELS[plane]};
+            scale[plane] = 1.0f / (255.0f * m_tensor.std[RGB]);
+            bias[plane]  = -m_tensor.mean[RGB] / m_tensor.std[RGB];
+        }
+    }
+
+    // The padding stays the same; it is written once per destination buffer
+    // by normalising a row of padding pixels into every row of the planes.
+    uint8_t *tensor{destinations.tensor};
+    if (m_paddedTensors.end() == std::find(m_paddedTensors.begin(), m_paddedTensors.end(), tensor)) {
+        m_paddedTensors.push_back(tensor);
+        if ((CW < TW) || (CH < TH)) {
+            const std::vector<uint8_t> PADDING(TW * 4, m_tensor.pad);
+            kernels::argbToTensor(PADDING.data(), 0, tensor, TW, TW * TH, TW, TH, TYPE, CHANNELS, scale, bias);
+        }
+    }
+
+    const uint8_t *argb{m_tensorARGB.empty() ? destinations.argb : m_tensorARGB.data()};
+    uint8_t *content{tensor + (m_tensorTop * TW + m_tensorLeft) * ELEMENT_SIZE};
+    const uint32_t STRIPES{m_workerPool.size()};
+    m_workerPool.parallelFor(STRIPES, [this, &destinations, &CHANNELS, &scale, &bias, argb, content, W, H, TW, TH, CW, CH, TYPE, ELEMENT_SIZE, STRIPES](uint32_t stripe) {
+        const auto ROWS{stripeRows(stripe, STRIPES, CH)};
+        if (ROWS.first < ROWS.second) {
+            const uint32_t FIRST{ROWS.first};
+            const uint32_t COUNT{ROWS.second - ROWS.first};
+            // Each stripe resamples its own rows, which are normalised while still in the cache.
+            if (!m_tensorARGB.empty()) {
+                libyuv::ARGBScaleClip(destinations.argb, W * 4, W, H,
+                                      m_tensorARGB.data(), CW * 4, CW, CH,
+                                      0, FIRST, CW, COUNT, libyuv::kFilterBilinear);
+            }
+            kernels::argbToTensor(argb + FIRST * CW * 4, CW * 4, content + FIRST * TW * ELEMENT_SIZE, TW, TW * TH, CW, COUNT, TYPE, CHANNELS, scale, bias);
+        }
+    });
+}
+
+void FrameConverter::cropStripe(const Destinations &destinations, uint32_t first, uint32_t last) noexcept {
+    const uint32_t W{m_width};
+    const uint32_t H{m_height};
+    for (uint32_t i{0}; i < m_crops.size(); i++) {
+        const Crop &crop{m_crops[i]};
+        // Crops and stripes start at even rows, so they share whole chroma rows.
+        const uint32_t FIRST{std::max(first, crop.y)};
+        const uint32_t LAST{std::min(last, crop.y + crop.height)};
+        if (FIRST >= LAST) {
+            continue;
+        }
+        const uint32_t CW{crop.width};
+        const uint32_t CH{crop.height};
+        const uint32_t ROW{FIRST - crop.y};
+        const uint32_t ROWS{LAST - FIRST};
+        if (nullptr != destinations.cropI420[i]) {
+            const uint8_t *i420{destinations.i420};
+            uint8_t *dst{m_cropI420[i].empty() ? destinations.cropI420[i] : m_cropI420[i].data()};
+            libyuv::CopyPlane(i420 + FIRST * W + crop.x, W, dst + ROW * CW, CW, CW, ROWS);
+            for (uint32_t plane{0}; plane < 2; plane++) {
+                const uint8_t *srcChroma{i420 + W * H + plane * ((W * H) >> 2)};
+                uint8_t *dstChroma{dst + CW * CH + plane * ((CW * CH) >> 2)};
+                libyuv::CopyPlane(srcChroma + (FIRST / 2) * (W / 2) + crop.x / 2, W / 2, dstChroma + (ROW / 2) * (CW / 2), CW / 2, CW / 2, (ROWS + 1) / 2);
+            }
+        }
+        if (nullptr != destinations.cropARGB[i]) {
+            uint8_t *dst{m_cropARGB[i].empty() ? destinations.cropARGB[i] : m_cropARGB[i].data()};
+            libyuv::CopyPlane(destinations.argb + FIRST * W * 4 + crop.x * 4, W * 4, dst + ROW * CW * 4, CW * 4, CW * 4, ROWS);
+        }
+    }
+}
+
+void FrameConverter::resampleCrops(const Destinations &destinations) noexcept {
+    m_workerPool.parallelFor(static_cast<uint32_t>(m_crops.size()), [this, &destinations](uint32_t i) {
+        const Crop &crop{m_crops[i]};
+        const uint32_t CW{crop.width};
+        const uint32_t CH{crop.height};
+        const uint32_t OW{crop.outputWidth};
+        const uint32_t OH{crop.outputHeight};
+        if ((nullptr != destinations.cropI420[i]) && !m_cropI420[i].empty()) {
+            const uint8_t *src{m_cropI420[i].data()};
+            uint8_t *dst{destinations.cropI420[i]};
+            libyuv::I420Scale(src, CW,
+                              src + CW * CH, CW / 2,
+                              src + CW * CH + ((CW * CH) >> 2), CW / 2,
+                              CW, CH,
+                              dst, OW,
+                              dst + OW * OH, OW / 2,
+                              dst + OW * OH + ((OW * OH) >> 2), OW / 2,
+                              OW, OH, libyuv::kFilterBilinear);
+        }
+        if ((nullptr != destinations.cropARGB[i]) && !m_cropARGB[i].empty()) {
+            libyuv::ARGBScale(m_cropARGB[i].data(), CW * 4, CW, CH,
+                              destinations.cropARGB[i], OW * 4, OW, OH, libyuv::kFilterBilinear);
+        }
+    });
+}
+
+void FrameConverter::buildPyramid(const Destinations &destinations) noexcept {
+    const uint32_t STRIPES{m_workerPool.size()};
+    for (uint32_t level{1}; level <= m_pyramidLevels; level++) {
+        // Each level is built from the one above it, which must be complete.
+        const uint8_t *srcI420{(1 == level) ? destinations.i420 : destinations.pyramidI420[level - 2]};
+        const uint8_t *srcARGB{(1 == level) ? destinations.argb : destinations.pyramidARGB[level - 2]};
+        uint8_t *dstI420{destinations.pyramidI420[level - 1]};
+        uint8_t *dstARGB{destinations.pyramidARGB[level - 1]};
+        const uint32_t SW{m_width >> (level - 1)};
+        const uint32_t SH{m_height >> (level - 1)};
+        const uint32_t W{SW / 2};
+        const uint32_t H{SH / 2};
+        m_workerPool.parallelFor(STRIPES, [srcI420, srcARGB, dstI420, dstARGB, SW, SH, W, H, STRIPES](uint32_t stripe) {
+            const auto ROWS{stripeRows(stripe, STRIPES, H)};
+            if (ROWS.first < ROWS.second) {
+                const uint32_t FIRST{ROWS.first};
+                const uint32_t COUNT{ROWS.second - ROWS.first};
+                kernels::halve(srcI420 + 2 * FIRST * SW, SW, dstI420 + FIRST * W, W, W, COUNT, 1);
+                // Both frames have an even height, so a stripe covers whole chroma rows.
+                for (uint32_t plane{0}; plane < 2; plane++) {
+                    const uint8_t *srcChroma{srcI420 + SW * SH + plane * ((SW * SH) >> 2)};
+                    uint8_t *dstChroma{dstI420 + W * H + plane * ((W * H) >> 2)};
+                    kernels::halve(srcChroma + FIRST * (SW / 2), SW / 2, dstChroma + (FIRST / 2) * (W / 2), W / 2, W / 2, COUNT / 2, 1);
+                }
+                if ((nullptr != srcARGB) && (nullptr != dstARGB)) {
+                    kernels::halve(srcARGB + 2 * FIRST * SW * 4, SW * 4, dstARGB + FIRST * W * 4, W * 4, W, COUNT, 4);
+                }
+            }
+        });
+    }
+}
+
+void FrameConverter::narrowStripe(const uint8_t *src, uint16_t *wide, uint8_t *narrow, uint32_t first, uint32_t last, uint8_t *scratch) noexcept {
+    const uint32_t W{m_width};
+    for (uint32_t row{first}; row < last; row++) {
+        const uint16_t *unpacked{reinterpret_cast<const uint16_t *>(src + row * W * 2)};
+        if (PixelFormat::MONO16 == m_pixelFormat) {
+            if (nullptr != wide) {
+                std::memcpy(wide + row * W, unpacked, W * sizeof(uint16_t));
+            }
+        } else {
+            uint16_t *dst{(nullptr != wide) ? wide + row * W : reinterpret_cast<uint16_t *>(scratch)};
+            kernels::unpack12p(src + row * W * 3 / 2, dst, W);
+            unpacked = dst;
+        }
+        if (nullptr != narrow) {
+            kernels::toneMap(unpacked, m_toneMap.data(), narrow + row * W, W);
+        }
+    }
+}
+
+void FrameConverter::convertStripe(const uint8_t *src, uint8_t *i420, uint8_t *argb, uint32_t first, uint32_t last, uint8_t *scratch, bool fillChroma) noexcept {
+    const uint32_t W{m_width};
+    const uint32_t H{m_height};
+    const uint32_t ROWS{last - first};
+    uint8_t *y{i420 + first * W};
+    uint8_t *u{i420 + W * H + (first / 2) * (W / 2)};
+    uint8_t *v{i420 + W * H + ((W * H) >> 2) + (first / 2) * (W / 2)};
+
+    if (PixelFormat::BAYER8 == m_narrowFormat) {
+        // Demosaic straight into both outputs; the kernel reads the rows
+        // around the stripe itself.
+        kernels::bayerToI420AndARGB(src, W, m_bayerPattern, m_demosaic,
+                                    i420, W,
+                                    i420 + W * H, W / 2,
+                                    i420 + W * H + ((W * H) >> 2), W / 2,
+                                    argb, W * 4,
+                                    W, H, first, last, scratch);
+    } else if (PixelFormat::MONO8 == m_narrowFormat) {
+        // Only the Y plane changes; tone mapped frames are already in place.
+        if (src != i420) {
+            std::memcpy(y, src + first * W, ROWS * W);
+        }
+        if (fillChroma) {
+            const uint32_t CHROMA_ROWS{(last + 1) / 2 - first / 2};
+            std::memset(u, 128, CHROMA_ROWS * (W / 2));
+            std::memset(v, 128, CHROMA_ROWS * (W / 2));
+        }
+        if (nullptr != argb) {
+            kernels::greyToARGB(y, W,
+                                argb + first * W * 4, W * 4,
+                                W, ROWS);
+        }
+    } else if (nullptr != argb) {
+        // Read the UYVY frame once to produce both I420 and ARGB.
+        kernels::uyvyToI420AndARGB(src + first * W * 2, W * 2 /* 2*WIDTH for YUYV 422*/,
+                                   y, W,
+                                   u, W / 2,
+                                   v, W / 2,
+                                   argb + first * W * 4, W * 4,
+                                   W, ROWS);
+    } else {
+        libyuv::UYVYToI420(src + first * W * 2, W * 2 /* 2*WIDTH for YUYV 422*/,
+                           y, W,
+                           u, W / 2,
+                           v, W / 2,
+                           W, ROWS);
+    }
+}
+
+void FrameConverter::deriveStripe(const uint8_t *src, const Destinations &destinations, uint32_t first, uint32_t last) noexcept {
+    const uint32_t W{m_width};
+    const uint32_t H{m_height};
+    const uint32_t ROWS{last - first};
+
+    if ((nullptr != destinations.uyvy) && (PixelFormat::UYVY == m_pixelFormat)) {
+        std::memcpy(destinations.uyvy + first * W * 2, src + first * W * 2, ROWS * W * 2);
+    }
+    if (nullptr != destinations.nv12) {
+        const uint8_t *i420{destinations.i420};
+        const uint32_t CHROMA_ROWS{(last + 1) / 2 - first / 2};
+        std::memcpy(destinations.nv12 + first * W, i420 + first * W, ROWS * W);
+        libyuv::MergeUVPlane(i420 + W * H + (first / 2) * (W / 2), W / 2,
+                             i420 + W * H + ((W * H) >> 2) + (first / 2) * (W / 2), W / 2,
+                             destinations.nv12 + W * H + (first / 2) * W, W,
+                             W / 2, CHROMA_ROWS);
+    }
+
+    const uint8_t *argb{(nullptr != destinations.argb) ? destinations.argb + first * W * 4 : nullptr};
+    if (nullptr != destinations.bgr24) {
+        // libyuv's RGB24 is B, G, R in memory, its RAW is R, G, B.
+        libyuv::ARGBToRGB24(argb, W * 4, destinations.bgr24 + first * W * 3, W * 3, W, ROWS);
+    }
+    if (nullptr != destinations.rgb24) {
+        libyuv::ARGBToRAW(argb, W * 4, destinations.rgb24 + first * W * 3, W * 3, W, ROWS);
+    }
+    if (nullptr != destinations.rgbPlanar) {
+        uint8_t *r{destinations.rgbPlanar + first * W};
+        kernels::argbToPlanarRGB(argb, W * 4, r, r + W * H, r + 2 * W * H, W, W, ROWS);
+    }
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_CONVERTER_HPP
+#define FRAME_CONVERTER_HPP
+
+#include "conversion-kernels.hpp"
+#include "remap-table.hpp"
+#include "worker-pool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Converts camera frames into the I420 and ARGB outputs. A frame is split
+ * into horizontal stripes of row pairs that are converted in parallel.
+ * Frames of more than 8 bits per pixel are first unpacked to 16 bits and
+ * tone mapped to 8 bits for the whole frame, as demosaicing reads across
+ * the stripe borders. Further formats are derived from the I420 or ARGB rows
+ * of a stripe while they are still in the cache; so are the rows of crops,
+ * which are resampled afterwards if they have an output size of their own.
+ * Pyramid levels halve the I420 and ARGB frames level by level with a 2x2
+ * box filter. A tensor is resampled from the ARGB frame in stripes and
+ * normalised into planes while the resampled rows are in the cache.
+ * Undistorted frames are interpolated from the complete I420 and ARGB
+ * frames through remap tables that are built once.
+ */
+class FrameConverter {
+   public:
+    enum class PixelFormat { UYVY, MONO8, MONO12P, MONO16, BAYER8, BAYER12P };
+
+    static constexpr uint32_t MAX_PYRAMID_LEVELS{4};
+    static constexpr uint32_t MAX_CROPS{8};
+
+    // Region of a frame that is published on its own.
+    struct Crop {
+        uint32_t x{0};
+        uint32_t y{0};
+        uint32_t width{0};
+        uint32_t height{0};
+        // Size to resample the region to; the region's size if 0.
+        uint32_t outputWidth{0};
+        uint32_t outputHeight{0};
+    };
+
+    // Three-plane CHW tensor of normalised values for inference.
+    struct Tensor {
+        // Size of a plane; no tensor if 0.
+        uint32_t width{0};
+        uint32_t height{0};
+        kernels::TensorType type{kernels::TensorType::FLOAT32};
+        // Planes in the order B, G, R instead of R, G, B.
+        bool bgr{false};
+        // Values (v / 255 - mean) / std of R, G, and B; ignored for UINT8.
+        float mean[3]{0.0f, 0.0f, 0.0f};
+        float std[3]{1.0f, 1.0f, 1.0f};
+        // Keep the aspect ratio and pad the borders instead of stretching the frame.
+        bool letterbox{true};
+        // Value of the padding in the range of the frame's pixels.
+        uint8_t pad{114};
+    };
+
+    // Frames to produce; nullptr to skip a format.
+    struct Destinations {
+        uint8_t *i420{nullptr};
+        // B, G, R, A in memory.
+        uint8_t *argb{nullptr};
+        // Unpacked, left-aligned 16-bit frame of high bit depth formats.
+        uint16_t *wide{nullptr};
+        // Y plane followed by interleaved U and V.
+        uint8_t *nv12{nullptr};
+        // B, G, R in memory.
+        uint8_t *bgr24{nullptr};
+        // R, G, B in memory.
+        uint8_t *rgb24{nullptr};
+        // R, G, and B planes.
+        uint8_t *rgbPlanar{nullptr};
+        // Copy of UYVY camera frames.
+        uint8_t *uyvy{nullptr};
+        // I420 and ARGB frames of the pyramid levels 1 to pyramidLevels(); all or none.
+        uint8_t *pyramidI420[MAX_PYRAMID_LEVELS]{};
+        uint8_t *pyramidARGB[MAX_PYRAMID_LEVELS]{};
+        // I420 and ARGB frames of the crops in the order of crops().
+        uint8_t *cropI420[MAX_CROPS]{};
+        uint8_t *cropARGB[MAX_CROPS]{};
+        // Tensor of tensor().width * tensor().height * 3 elements.
+        uint8_t *tensor{nullptr};
+        // Undistorted I420 and ARGB frames if the converter has a calibration.
+        uint8_t *undistortedI420{nullptr};
+        uint8_t *undistortedARGB{nullptr};
+    };
+
+   private:
+    FrameConverter(const FrameConverter &) = delete;
+    FrameConverter(FrameConverter &&)      = delete;
+    FrameConverter &operator=(const FrameConverter &) = delete;
+    FrameConverter &operator=(FrameConverter &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param width Width of a frame.
+     * @param height Height of a frame.
+     * @param pixelFormat Pixel format of the camera frames.
+     * @param bayerPattern Colour filter arrangement of Bayer frames.
+     * @param demosaic Interpolation method for Bayer frames.
+     * @param toneMap Table of ToneMap::SIZE entries for frames of more than 8 bits per pixel.
+     * @param pyramidLevels Number of requested pyramid levels below the full resolution.
+     * @param crops Regions to publish on their own; at most MAX_CROPS.
+     * @param tensor Tensor to produce from the ARGB frame.
+     * @param calibration Calibration for the undistorted frames; none if invalid.
+     * @param workerPool Threads to run the stripes on.
+     */
+    FrameConverter(uint32_t width, uint32_t height, PixelFormat pixelFormat, kernels::BayerPattern bayerPattern, kernels::Demosaic demosaic, const std::vector<uint8_t> &toneMap, uint32_t pyramidLevels, const std::vector<Crop> &crops, const Tensor &tensor, const RemapTable::Calibration &calibration, WorkerPool &workerPool) noexcept;
+    ~FrameConverter() = default;
+
+   public:
+    /**
+     * This method converts a camera frame.
+     *
+     * @param src Camera frame.
+     * @param destinations Frames to produce.
+     */
+    void convert(const uint8_t *src, Destinations destinations) noexcept;
+
+    /**
+     * @return true if the camera frames have more than 8 bits per pixel.
+     */
+    bool isHighBitDepth() const noexcept;
+
+    /**
+     * @return Number of pyramid levels; a level is only built if the level
+     *         above it has a width and a height that are multiples of 4.
+     */
+    uint32_t pyramidLevels() const noexcept;
+
+    /**
+     * @param level Pyramid level from 1 to pyramidLevels().
+     * @return Width and height of a frame of the given level.
+     */
+    std::pair<uint32_t, uint32_t> pyramidSize(uint32_t level) const noexcept;
+
+    /**
+     * @return Crops with even positions and sizes that lie within the frame,
+     *         and their output sizes set.
+     */
+    const std::vector<Crop> &crops() const noexcept;
+
+    /**
+     * @return Tensor to produce.
+     */
+    const Tensor &tensor() const noexcept;
+
+    /**
+     * @return Size in bytes of a tensor; 0 if there is none.
+     */
+    uint32_t tensorSize() const noexcept;
+
+    /**
+     * @return true if undistorted frames can be produced.
+     */
+    bool canUndistort() const noexcept;
+
+   private:
+    void narrowStripe(const uint8_t *src, uint16_t *wide, uint8_t *narrow, uint32_t first, uint32_t last, uint8_t *scratch) noexcept;
+    void convertStripe(const uint8_t *src, uint8_t *i420, uint8_t *argb, uint32_t first, uint32_t last, uint8_t *scratch, bool fillChroma) noexcept;
+    void deriveStripe(const uint8_t *src, const Destinations &destinations, uint32_t first, uint32_t last) noexcept;
+    void buildPyramid(const Destinations &destinations) noexcept;
+    void cropStripe(const Destinations &destinations, uint32_t first, uint32_t last) noexcept;
+    void resampleCrops(const Destinations &destinations) noexcept;
+    void buildTensor(const Destinations &destinations) noexcept;
+    void undistort(const Destinations &destinations) noexcept;
+
+   private:
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const PixelFormat m_pixelFormat;
+    // Format of the 8-bit frames that are converted into I420 and ARGB.
+    const PixelFormat m_narrowFormat;
+    const kernels::BayerPattern m_bayerPattern;
+    const kernels::Demosaic m_demosaic;
+    const std::vector<uint8_t> m_toneMap;
+    const uint32_t m_pyramidLevels;
+    const std::vector<Crop> m_crops;
+    const Tensor m_tensor;
+    WorkerPool &m_workerPool;
+    // Line buffers of each stripe for unpacking and demosaicing.
+    std::vector<std::vector<uint8_t>> m_scratch;
+    // Tone mapped Bayer frame if the camera frames have more than 8 bits per pixel.
+    std::vector<uint8_t> m_narrow;
+    // I420 and ARGB frames to derive other formats from if these outputs are skipped.
+    std::vector<uint8_t> m_i420;
+    std::vector<uint8_t> m_argb;
+    // Regions of the crops that are resampled to another size.
+    std::vector<std::vector<uint8_t>> m_cropI420;
+    std::vector<std::vector<uint8_t>> m_cropARGB;
+    // I420 buffers whose chroma planes are already filled for monochrome frames.
+    std::vector<uint8_t *> m_neutralChroma;
+    // Region of the tensor's planes that the frame is resampled to; the rest is padding.
+    uint32_t m_tensorLeft{0};
+    uint32_t m_tensorTop{0};
+    uint32_t m_tensorWidth{0};
+    uint32_t m_tensorHeight{0};
+    // Resampled frame if its size differs from the frame's size.
+    std::vector<uint8_t> m_tensorARGB;
+    // Tensor buffers whose padding is already filled.
+    std::vector<uint8_t *> m_paddedTensors;
+    // Source positions of the undistorted Y plane and ARGB frame, and of the chroma planes.
+    std::unique_ptr<RemapTable> m_remapLuma;
+    std::unique_ptr<RemapTable> m_remapChroma;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame-event-handler.hpp"
+
+#include <iostream>
+
+FrameEventHandler::FrameEventHandler(FrameQueue<Frame> &frameQueue, StreamStatistics &streamStatistics, bool withChunkData, bool debug, uint64_t generation, uint32_t poolSize) noexcept
+    : m_frameQueue{frameQueue}
+    , m_streamStatistics{streamStatistics}
+    , m_withChunkData{withChunkData}
+    , m_debug{debug}
+    , m_generation{generation}
+    , m_images(poolSize)
+    , m_inUse{new std::atomic<bool>[poolSize]} {
+    for (uint32_t i{0}; i < poolSize; i++) {
+        m_inUse[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+void FrameEventHandler::OnImageEvent(Spinnaker::ImagePtr image) {
+    if (m_streamStatistics.countFrame(image)) {
+        uint32_t slot{0};
+        bool expected{false};
+        while ((slot < m_images.size()) && !m_inUse[slot].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            expected = false;
+            slot++;
+        }
+        if (m_images.size() == slot) {
+            if (m_debug) {
+                std::clog << "[opendlv-device-camera-spinnaker]: No free image to copy a frame into; frame dropped." << std::endl;
+            }
+            return;
+        }
+        // An image is only allocated for its first frame; later copies of frames of the same size reuse its buffer.
+        if (!m_images[slot].IsValid()) {
+            m_images[slot] = Spinnaker::Image::Create();
+        }
+        m_images[slot]->DeepCopy(image);
+        Frame frame;
+        frame.image      = m_images[slot];
+        frame.generation = m_generation;
+        frame.pooled     = &m_inUse[slot];
+        describeFrame(frame, image, m_withChunkData);
+        if (!m_frameQueue.push(std::move(frame)) && m_debug) {
+            std::clog << "[opendlv-device-camera-spinnaker]: Frame queue full, " << m_frameQueue.dropped() << " frames dropped so far." << std::endl;
+        }
+    }
+}
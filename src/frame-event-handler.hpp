@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_EVENT_HANDLER_HPP
+#define FRAME_EVENT_HANDLER_HPP
+
+#include "frame-queue.hpp"
+#include "frame.hpp"
+#include "stream-statistics.hpp"
+
+#include <Spinnaker.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Image event handler that pushes frames into the frame queue as soon as
+ * the transport layer has completed them. The camera buffer is handed back
+ * to the stream once the callback returns; hence, each frame is copied into
+ * one of a fixed set of images that are allocated with the first frames and
+ * reused after the conversion has released them.
+ */
+class FrameEventHandler : public Spinnaker::ImageEventHandler {
+   private:
+    FrameEventHandler(const FrameEventHandler &) = delete;
+    FrameEventHandler(FrameEventHandler &&)      = delete;
+    FrameEventHandler &operator=(const FrameEventHandler &) = delete;
+    FrameEventHandler &operator=(FrameEventHandler &&) = delete;
+
+   public:
+    FrameEventHandler(FrameQueue<Frame> &frameQueue, StreamStatistics &streamStatistics, bool withChunkData, bool debug, uint64_t generation, uint32_t poolSize) noexcept;
+    ~FrameEventHandler() override = default;
+
+   public:
+    void OnImageEvent(Spinnaker::ImagePtr image) override;
+
+   private:
+    FrameQueue<Frame> &m_frameQueue;
+    StreamStatistics &m_streamStatistics;
+    bool m_withChunkData;
+    bool m_debug;
+    // Generation of the stream that the handler is registered for.
+    uint64_t m_generation;
+    // Images to copy frames into, and whether they are queued or converted.
+    std::vector<Spinnaker::ImagePtr> m_images;
+    std::unique_ptr<std::atomic<bool>[]> m_inUse;
+};
+
+#endif
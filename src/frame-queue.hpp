@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_QUEUE_HPP
+#define FRAME_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Bounded lock-free queue to hand frames from the acquisition thread to the
+ * conversion stage (one producer, one consumer). Each cell carries a sequence
+ * number so that the producer can also act as a consumer to evict the oldest
+ * entry when the queue is full; the consumer only sleeps on the condition
+ * variable when the queue is empty.
+ */
+template <typename T>
+class FrameQueue {
+   public:
+    enum class DropPolicy { DROP_OLDEST, DROP_NEWEST };
+
+    /**
+     * @param policy Name of the drop policy ("oldest" or "newest").
+     * @return Parsed drop policy; DROP_OLDEST for unknown names.
+     */
+    static DropPolicy dropPolicyFromString(const std::string &policy) noexcept {
+        return ("newest" == policy) ? DropPolicy::DROP_NEWEST : DropPolicy::DROP_OLDEST;
+    }
+
+   private:
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        T item{};
+    };
+
+   private:
+    FrameQueue(const FrameQueue &) = delete;
+    FrameQueue(FrameQueue &&)      = delete;
+    FrameQueue &operator=(const FrameQueue &) = delete;
+    FrameQueue &operator=(FrameQueue &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param capacity Maximum number of queued frames (at least 1).
+     * @param policy What to discard when the queue is full.
+     * @param onDrop Delegate to release a discarded frame.
+     */
+    FrameQueue(uint32_t capacity, DropPolicy policy, std::function<void(T &)> onDrop) noexcept
+        : m_capacity{(0 < capacity) ? capacity : 1}
+        , m_policy{policy}
+        , m_onDrop{onDrop}
+        , m_cells{new Cell[(0 < capacity) ? capacity : 1]} {
+        for (uint64_t i{0}; i < m_capacity; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~FrameQueue() {
+        T item{};
+        while (tryPop(item)) {
+            drop(item);
+        }
+    }
+
+   public:
+    /**
+     * This method enqueues a frame and wakes up the consumer.
+     *
+     * @param item Frame to enqueue.
+     * @return false if a frame had to be dropped to respect the capacity.
+     */
+    bool push(T &&item) noexcept {
+        bool retVal{true};
+        if (DropPolicy::DROP_NEWEST == m_policy) {
+            if (!tryPush(item)) {
+                drop(item);
+                return false;
+            }
+        } else {
+            while (!tryPush(item)) {
+                T oldest{};
+                if (tryPop(oldest)) {
+                    drop(oldest);
+                    retVal = false;
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+        }
+        m_condition.notify_one();
+        return retVal;
+    }
+
+    /**
+     * This method dequeues a frame without blocking.
+     *
+     * @param item Dequeued frame.
+     * @return true if a frame was dequeued.
+     */
+    bool tryPop(T &item) noexcept {
+        uint64_t pos{m_dequeuePosition.load(std::memory_order_relaxed)};
+        Cell *cell{nullptr};
+        for (;;) {
+            cell = &m_cells[pos % m_capacity];
+            const int64_t diff{static_cast<int64_t>(cell->sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(pos + 1)};
+            if (0 == diff) {
+                if (m_dequeuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (0 > diff) {
+                return false;
+            } else {
+                pos = m_dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        item       = std::move(cell->item);
+        cell->item = T{};
+        cell->sequence.store(pos + m_capacity, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * This method dequeues a frame and waits for one if the queue is empty.
+     *
+     * @param item Dequeued frame.
+     * @param timeout Maximum time to wait.
+     * @return true if a frame was dequeued.
+     */
+    bool waitAndPop(T &item, std::chrono::milliseconds timeout) noexcept {
+        if (tryPop(item)) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lck(m_mutex);
+        return m_condition.wait_for(lck, timeout, [this, &item]() { return tryPop(item); });
+    }
+
+    /**
+     * @return Number of frames dropped so far.
+     */
+    uint64_t dropped() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    bool tryPush(T &item) noexcept {
+        uint64_t pos{m_enqueuePosition.load(std::memory_order_relaxed)};
+        Cell *cell{nullptr};
+        for (;;) {
+            cell = &m_cells[pos % m_capacity];
+            const int64_t diff{static_cast<int64_t>(cell->sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(pos)};
+            if (0 == diff) {
+                if (m_enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (0 > diff) {
+                return false;
+            } else {
+                pos = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drop(T &item) noexcept {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        if (m_onDrop) {
+            m_onDrop(item);
+        }
+    }
+
+   private:
+    const uint64_t m_capacity;
+    const DropPolicy m_policy;
+    std::function<void(T &)> m_onDrop;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // Padding instead of alignas keeps the producer's and the consumer's
+    // positions on separate cache lines also for heap-allocated queues.
+    char m_padding0[64]{};
+    std::atomic<uint64_t> m_enqueuePosition{0};
+    char m_padding1[64]{};
+    std::atomic<uint64_t> m_dequeuePosition{0};
+    char m_padding2[64]{};
+    std::atomic<uint64_t> m_dropped{0};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_condition{};
+};
+
+#endif
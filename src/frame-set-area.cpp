@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame-set-area.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+FrameSetArea::Key FrameSetArea::keyFromString(const std::string &key) noexcept {
+    return ("frameid" == key) ? Key::FRAME_ID : Key::TIMESTAMP;
+}
+
+FrameSetArea::FrameSetArea(const std::string &name, uint32_t frameCount, uint32_t frameSize, uint32_t width, uint32_t height, uint32_t fourcc, uint32_t slots, Key key, int64_t tolerance) noexcept
+    : m_frameCount{frameCount}
+    , m_frameSize{frameSize}
+    , m_key{key}
+    , m_tolerance{tolerance}
+    , m_pendingSets(std::min(std::max(slots, 3u), layout::MAX_SLOTS))
+    , m_hasFirstFrameId(frameCount, false)
+    , m_firstFrameId(frameCount, 0)
+    , m_realign(frameCount, false)
+    , m_lastKey(frameCount, 0) {
+    const uint32_t COUNT{static_cast<uint32_t>(m_pendingSets.size())};
+    const uint64_t FRAME_STRIDE{layout::alignUp(frameSize, layout::CACHE_LINE)};
+    const uint64_t SLOT_SIZE{frameCount * FRAME_STRIDE + frameCount * sizeof(layout::FrameMetadata)};
+    const uint64_t STRIDE{layout::alignUp(SLOT_SIZE, layout::CACHE_LINE)};
+    const uint64_t SIZE{layout::alignUp(layout::CACHE_LINE + COUNT * STRIDE, layout::CACHE_LINE) + sizeof(layout::Trailer)};
+    for (auto &pendingSet : m_pendingSets) {
+        pendingSet.present.resize(frameCount, false);
+    }
+    m_sharedMemory.reset(new cluon::SharedMemory{name, static_cast<uint32_t>(SIZE)});
+    if (m_sharedMemory && m_sharedMemory->valid()) {
+        char *data{m_sharedMemory->data()};
+        m_trailer = layout::trailerOf(data, m_sharedMemory->size());
+        std::memset(static_cast<void *>(m_trailer), 0, sizeof(layout::Trailer));
+        m_trailer->magic           = layout::MAGIC;
+        m_trailer->version         = layout::VERSION;
+        m_trailer->fourcc          = fourcc;
+        m_trailer->width           = width;
+        m_trailer->height          = height;
+        m_trailer->slotCount       = COUNT;
+        m_trailer->slotSize        = static_cast<uint32_t>(SLOT_SIZE);
+        m_trailer->slotStride      = static_cast<uint32_t>(STRIDE);
+        m_trailer->firstSlotOffset = static_cast<uint32_t>(layout::alignUp(reinterpret_cast<uint64_t>(data), layout::CACHE_LINE) - reinterpret_cast<uint64_t>(data));
+        m_trailer->frameCount      = frameCount;
+        m_trailer->frameStride     = static_cast<uint32_t>(FRAME_STRIDE);
+        m_trailer->latest.store(COUNT - 1);
+    }
+}
+
+bool FrameSetArea::valid() noexcept {
+    return (m_sharedMemory && m_sharedMemory->valid() && (nullptr != m_trailer));
+}
+
+std::string FrameSetArea::name() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->name() : "");
+}
+
+uint32_t FrameSetArea::size() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->size() : 0);
+}
+
+uint64_t FrameSetArea::incompleteSets() noexcept {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    return m_incompleteSets;
+}
+
+void FrameSetArea::add(uint32_t index, const layout::FrameMetadata &metadata, const uint8_t *frame) noexcept {
+    if (index >= m_frameCount) {
+        return;
+    }
+
+    int32_t slotIndex{-1};
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        int64_t key{static_cast<int64_t>(metadata.cameraTimestamp)};
+        if (Key::FRAME_ID == m_key) {
+            if (!m_hasFirstFrameId[index]) {
+                const int64_t FIRST_KEY{m_realign[index] ? alignedKey(index) : 0};
+                m_hasFirstFrameId[index] = true;
+                m_realign[index]         = false;
+                m_firstFrameId[index]    = metadata.frameId - static_cast<uint64_t>(FIRST_KEY);
+            }
+            key              = static_cast<int64_t>(metadata.frameId - m_firstFrameId[index]);
+            m_lastKey[index] = key;
+        }
+        slotIndex = reserve(index, key);
+        if (0 > slotIndex) {
+            return;
+        }
+    }
+
+    // The frames of a set are copied in parallel outside of the lock.
+    uint8_t *dst{slot(static_cast<uint32_t>(slotIndex))};
+    std::memcpy(dst + index * m_trailer->frameStride, frame, m_frameSize);
+    std::memcpy(dst + m_frameCount * m_trailer->frameStride + index * sizeof(layout::FrameMetadata), &metadata, sizeof(layout::FrameMetadata));
+
+    bool complete{false};
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        PendingSet &pendingSet{m_pendingSets[static_cast<uint32_t>(slotIndex)]};
+        pendingSet.writers--;
+        pendingSet.arrived++;
+        if (pendingSet.active && (m_frameCount == pendingSet.arrived)) {
+            // The set's header carries the metadata of the first camera with
+            // the frame ID replaced by the number of the set.
+            layout::SlotHeader &header{m_trailer->slots[slotIndex]};
+            std::memcpy(&header.metadata, dst + m_frameCount * m_trailer->frameStride, sizeof(layout::FrameMetadata));
+            header.metadata.frameId = m_sequence + 1;
+            header.timestamp        = static_cast<int64_t>(header.metadata.cameraTimestamp / 1000);
+            header.sequence.store(++m_sequence, std::memory_order_release);
+            m_trailer->latest.store(static_cast<uint32_t>(slotIndex), std::memory_order_release);
+            pendingSet.active = false;
+            complete          = true;
+        }
+    }
+    if (complete) {
+        m_sharedMemory->notifyAll();
+    }
+}
+
+void FrameSetArea::resetCamera(uint32_t index) noexcept {
+    if (index >= m_frameCount) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(m_mutex);
+    m_hasFirstFrameId[index] = false;
+    m_realign[index]         = true;
+    // Frames that are still being copied keep their slot until they are done.
+    for (auto &pendingSet : m_pendingSets) {
+        if (pendingSet.active && pendingSet.present[index]) {
+            pendingSet.active = false;
+            m_incompleteSets++;
+        }
+    }
+}
+
+// A restarted camera joins the newest set that the others have started
+// without it; if there is none, its frame belongs to the next trigger.
+int64_t FrameSetArea::alignedKey(uint32_t index) const noexcept {
+    bool withPendingSet{false};
+    uint64_t newestOrder{0};
+    int64_t retVal{0};
+    for (const auto &pendingSet : m_pendingSets) {
+        if (pendingSet.active && !pendingSet.present[index] && (!withPendingSet || (pendingSet.order > newestOrder))) {
+            withPendingSet = true;
+            newestOrder    = pendingSet.order;
+            retVal         = pendingSet.key;
+        }
+    }
+    if (withPendingSet) {
+        return retVal;
+    }
+    bool withOthers{false};
+    for (uint32_t i{0}; i < m_frameCount; i++) {
+        if ((i != index) && m_hasFirstFrameId[i]) {
+            retVal     = withOthers ? std::max(retVal, m_lastKey[i] + 1) : m_lastKey[i] + 1;
+            withOthers = true;
+        }
+    }
+    return retVal;
+}
+
+int32_t FrameSetArea::reserve(uint32_t index, int64_t key) noexcept {
+    const uint32_t LATEST{m_trailer->latest.load(std::memory_order_relaxed)};
+
+    // Join the matching set of the other cameras.
+    for (uint32_t i{0}; i < m_pendingSets.size(); i++) {
+        PendingSet &pendingSet{m_pendingSets[i]};
+        if (pendingSet.active && !pendingSet.present[index]) {
+            const int64_t DIFFERENCE{(pendingSet.key > key) ? pendingSet.key - key : key - pendingSet.key};
+            if (((Key::TIMESTAMP == m_key) && (DIFFERENCE <= m_tolerance)) || ((Key::FRAME_ID == m_key) && (0 == DIFFERENCE))) {
+                pendingSet.present[index] = true;
+                pendingSet.writers++;
+                return static_cast<int32_t>(i);
+            }
+        }
+    }
+
+    // Start a new set in a free slot; the latest complete set is never
+    // overwritten, and the oldest incomplete set is discarded if necessary.
+    int32_t freeSlot{-1};
+    int32_t oldest{-1};
+    for (uint32_t i{0}; i < m_pendingSets.size(); i++) {
+        const PendingSet &pendingSet{m_pendingSets[i]};
+        if ((LATEST == i) || (0 < pendingSet.writers)) {
+            continue;
+        }
+        if (!pendingSet.active) {
+            freeSlot = static_cast<int32_t>(i);
+            break;
+        }
+        if ((0 > oldest) || (pendingSet.order < m_pendingSets[static_cast<uint32_t>(oldest)].order)) {
+            oldest = static_cast<int32_t>(i);
+        }
+    }
+    if (0 > freeSlot) {
+        if (0 > oldest) {
+            return -1;
+        }
+        m_incompleteSets++;
+        freeSlot = oldest;
+    }
+
+    PendingSet &pendingSet{m_pendingSets[static_cast<uint32_t>(freeSlot)]};
+    pendingSet.active  = true;
+    pendingSet.key     = key;
+    pendingSet.order   = m_order++;
+    pendingSet.arrived = 0;
+    pendingSet.writers = 1;
+    std::fill(pendingSet.present.begin(), pendingSet.present.end(), false);
+    pendingSet.present[index] = true;
+    m_trailer->slots[freeSlot].sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return freeSlot;
+}
+
+uint8_t *FrameSetArea::slot(uint32_t index) noexcept {
+    return reinterpret_cast<uint8_t *>(m_sharedMemory->data() + m_trailer->firstSlotOffset + index * m_trailer->slotStride);
+}
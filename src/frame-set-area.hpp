@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_SET_AREA_HPP
+#define FRAME_SET_AREA_HPP
+
+#include "cluon-complete.hpp"
+#include "shared-memory-layout.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Output area for synchronized frame sets: the frames of all cameras that
+ * belong to the same trigger are collected in one slot of a ring (cf.
+ * shared-memory-layout.hpp), and the slot is published and readers are
+ * woken up only once the set is complete. Frames belong to the same set if
+ * their camera time stamps are within a tolerance or, alternatively, if
+ * they have the same frame ID relative to the first frame of each camera.
+ * A camera that restarts streaming counts its frame IDs from 0 again; its
+ * first frame after resetCamera() is aligned to the sets of the others.
+ */
+class FrameSetArea {
+   public:
+    enum class Key { TIMESTAMP, FRAME_ID };
+
+    /**
+     * @param key Name of the key ("timestamp" or "frameid").
+     * @return Parsed key; TIMESTAMP for unknown names.
+     */
+    static Key keyFromString(const std::string &key) noexcept;
+
+   private:
+    struct PendingSet {
+        bool active{false};
+        // Camera time stamp in nanoseconds or relative frame ID.
+        int64_t key{0};
+        uint64_t order{0};
+        uint32_t arrived{0};
+        uint32_t writers{0};
+        std::vector<bool> present{};
+    };
+
+   private:
+    FrameSetArea(const FrameSetArea &) = delete;
+    FrameSetArea(FrameSetArea &&)      = delete;
+    FrameSetArea &operator=(const FrameSetArea &) = delete;
+    FrameSetArea &operator=(FrameSetArea &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param name Name of the shared memory area.
+     * @param frameCount Number of cameras per set.
+     * @param frameSize Size of one frame.
+     * @param width Width of a frame.
+     * @param height Height of a frame.
+     * @param fourcc Pixel format of a frame.
+     * @param slots Number of slots (3 to layout::MAX_SLOTS); all but two may hold incomplete sets.
+     * @param key How frames are matched.
+     * @param tolerance Maximum difference of camera time stamps within a set in nanoseconds.
+     */
+    FrameSetArea(const std::string &name, uint32_t frameCount, uint32_t frameSize, uint32_t width, uint32_t height, uint32_t fourcc, uint32_t slots, Key key, int64_t tolerance) noexcept;
+    ~FrameSetArea() = default;
+
+   public:
+    bool valid() noexcept;
+    std::string name() const noexcept;
+    uint32_t size() const noexcept;
+
+    /**
+     * This method adds a camera's frame to its set; it may be called from
+     * the conversion threads of all cameras concurrently. The set is
+     * published once the frames of all cameras have been added.
+     *
+     * @param index Index of the camera within the set.
+     * @param metadata Metadata of the frame.
+     * @param frame Frame data.
+     */
+    void add(uint32_t index, const layout::FrameMetadata &metadata, const uint8_t *frame) noexcept;
+
+    /**
+     * This method forgets a camera's frame IDs before it restarts streaming
+     * and discards the incomplete sets that it has already contributed to.
+     *
+     * @param index Index of the camera within the set.
+     */
+    void resetCamera(uint32_t index) noexcept;
+
+    /**
+     * @return Number of sets that were discarded before they were complete.
+     */
+    uint64_t incompleteSets() noexcept;
+
+   private:
+    int32_t reserve(uint32_t index, int64_t key) noexcept;
+    int64_t alignedKey(uint32_t index) const noexcept;
+    uint8_t *slot(uint32_t index) noexcept;
+
+   private:
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory{nullptr};
+    layout::Trailer *m_trailer{nullptr};
+    const uint32_t m_frameCount;
+    const uint32_t m_frameSize;
+    const Key m_key;
+    const int64_t m_tolerance;
+
+    std::mutex m_mutex{};
+    std::vector<PendingSet> m_pendingSets{};
+    std::vector<bool> m_hasFirstFrameId{};
+    std::vector<uint64_t> m_firstFrameId{};
+    // Cameras whose next frame is aligned to the others' sets, and the relative frame ID of each camera's last frame.
+    std::vector<bool> m_realign{};
+    std::vector<int64_t> m_lastKey{};
+    uint64_t m_order{0};
+    uint64_t m_sequence{0};
+    uint64_t m_incompleteSets{0};
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_HPP
+#define FRAME_HPP
+
+#include "cluon-complete.hpp"
+#include "shared-memory-layout.hpp"
+
+#include <Spinnaker.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * A grabbed frame on its way from acquisition to conversion.
+ */
+struct Frame {
+    Spinnaker::ImagePtr image{nullptr};
+    // Camera state and time stamps; metadata.cameraTimestamp is in nanoseconds.
+    layout::FrameMetadata metadata{};
+    // True if the image is a buffer of the camera's stream that must be released.
+    bool isCameraBuffer{false};
+    // Stream that delivered the frame; the images of a stopped stream must not be touched.
+    uint64_t generation{0};
+    // Flag of the preallocated image that holds a copy of the frame; cleared on release.
+    std::atomic<bool> *pooled{nullptr};
+};
+
+/**
+ * This function stamps a frame that was just received from the camera.
+ *
+ * @param frame Frame to describe.
+ * @param image Image as delivered by the camera.
+ * @param withChunkData True if the camera appends exposure and gain chunks.
+ */
+inline void describeFrame(Frame &frame, const Spinnaker::ImagePtr &image, bool withChunkData) noexcept {
+    frame.metadata.version         = layout::METADATA_VERSION;
+    frame.metadata.flags           = layout::METADATA_FRAME_ID | layout::METADATA_CAMERA_TIMESTAMP | layout::METADATA_HOST_RECEIVE_TIME;
+    frame.metadata.frameId         = image->GetFrameID();
+    frame.metadata.cameraTimestamp = image->GetTimeStamp();
+    frame.metadata.hostReceiveTime = cluon::time::toMicroseconds(cluon::time::now());
+    if (withChunkData) {
+        // Chunks are parsed from the payload; no node is queried on the camera.
+        try {
+            const Spinnaker::ChunkData &chunkData{image->GetChunkData()};
+            frame.metadata.exposureTime = chunkData.GetExposureTime();
+            frame.metadata.gain         = chunkData.GetGain();
+            frame.metadata.flags |= layout::METADATA_EXPOSURE_TIME | layout::METADATA_GAIN;
+        }
+        catch (...) {
+            // Frame without chunk data.
+        }
+    }
+}
+
+/**
+ * This function returns the frame's image to its owner.
+ *
+ * @param frame Frame to release.
+ */
+inline void releaseFrame(Frame &frame) noexcept {
+    if (frame.isCameraBuffer && frame.image.IsValid()) {
+        try {
+            frame.image->Release();
+        }
+        catch (...) {
+            // Stream is already stopped.
+        }
+    }
+    if (nullptr != frame.pooled) {
+        frame.pooled->store(false, std::memory_order_release);
+    }
+    frame.image = nullptr;
+    frame.isCameraBuffer = false;
+    frame.pooled = nullptr;
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hot-plug-event-handler.hpp"
+
+HotPlugEventHandler::HotPlugEventHandler(std::function<void(uint64_t, bool)> delegate) noexcept
+    : m_delegate{delegate} {
+}
+
+void HotPlugEventHandler::OnDeviceArrival(uint64_t serialNumber) {
+    if (m_delegate) {
+        m_delegate(serialNumber, true);
+    }
+}
+
+void HotPlugEventHandler::OnDeviceRemoval(uint64_t serialNumber) {
+    if (m_delegate) {
+        m_delegate(serialNumber, false);
+    }
+}
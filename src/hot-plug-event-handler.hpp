@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOT_PLUG_EVENT_HANDLER_HPP
+#define HOT_PLUG_EVENT_HANDLER_HPP
+
+#include <Spinnaker.h>
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * Interface event handler that forwards the arrival and removal of cameras
+ * on any interface by their serial numbers.
+ */
+class HotPlugEventHandler : public Spinnaker::InterfaceEventHandler {
+   private:
+    HotPlugEventHandler(const HotPlugEventHandler &) = delete;
+    HotPlugEventHandler(HotPlugEventHandler &&)      = delete;
+    HotPlugEventHandler &operator=(const HotPlugEventHandler &) = delete;
+    HotPlugEventHandler &operator=(HotPlugEventHandler &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param delegate Function to call with a camera's serial number and true if it arrived or false if it was removed.
+     */
+    HotPlugEventHandler(std::function<void(uint64_t, bool)> delegate) noexcept;
+    ~HotPlugEventHandler() override = default;
+
+   public:
+    void OnDeviceArrival(uint64_t serialNumber) override;
+    void OnDeviceRemoval(uint64_t serialNumber) override;
+
+   private:
+    std::function<void(uint64_t, bool)> m_delegate;
+};
+
+#endif
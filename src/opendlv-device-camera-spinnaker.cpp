@@ -15,316 +15,478 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "bandwidth-planner.hpp"
+#include "camera-discovery.hpp"
+#include "camera-pipeline.hpp"
 #include "cluon-complete.hpp"
+#include "frame-queue.hpp"
+#include "frame-set-area.hpp"
+#include "frame.hpp"
+#include "hot-plug-event-handler.hpp"
+#include "remap-table.hpp"
+#include "shared-memory-area.hpp"
+#include "shared-memory-layout.hpp"
+#include "tone-map.hpp"
+#include "worker-pool.hpp"
 
 #include <Spinnaker.h>
 
 #include <X11/Xlib.h>
-#include <libyuv.h>
-#include <sys/time.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Splits a comma-separated command line value into its entries.
+static std::vector<std::string> splitList(const std::string &value) {
+    std::vector<std::string> retVal;
+    std::stringstream sstr{value};
+    std::string entry;
+    while (std::getline(sstr, entry, ',')) {
+        if (!entry.empty()) {
+            retVal.push_back(entry);
+        }
+    }
+    return retVal;
+}
+
+// Returns the entry for the given camera; the last entry applies to all
+// further cameras.
+static std::string entryFor(const std::vector<std::string> &entries, uint32_t index, const std::string &defaultValue) {
+    if (entries.empty()) {
+        return defaultValue;
+    }
+    return (index < entries.size()) ? entries[index] : entries.back();
+}
+
+// Parses a crop given as WxH+X+Y with an optional output size @WxH.
+static bool parseCrop(const std::string &value, FrameConverter::Crop &crop) {
+    int consumed{0};
+    if ((4 != std::sscanf(value.c_str(), "%ux%u+%u+%u%n", &crop.width, &crop.height, &crop.x, &crop.y, &consumed)) || (0 == crop.width) || (0 == crop.height)) {
+        return false;
+    }
+    const std::string OUTPUT{value.substr(static_cast<std::size_t>(consumed))};
+    if (OUTPUT.empty()) {
+        return true;
+    }
+    char end{0};
+    return (2 == std::sscanf(OUTPUT.c_str(), "@%ux%u%c", &crop.outputWidth, &crop.outputHeight, &end)) && (0 < crop.outputWidth) && (0 < crop.outputHeight);
+}
+
+// Parses the values of the R, G, and B channels given as r,g,b.
+static bool parseRGB(const std::string &value, float rgb[3]) {
+    char end{0};
+    return (3 == std::sscanf(value.c_str(), "%f,%f,%f%c", &rgb[0], &rgb[1], &rgb[2], &end));
+}
 
 int32_t main(int32_t argc, char **argv) {
+    const int64_t START_TIME{cluon::time::toMicroseconds(cluon::time::now())};
     int32_t retCode{0};
     auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
     if ( (0 == commandlineArguments.count("camera")) ||
          (0 == commandlineArguments.count("width")) ||
          (0 == commandlineArguments.count("height")) ) {
-        std::cerr << argv[0] << " interfaces with a Pylon camera (given by the numerical identifier, e.g., 0) and provides the captured image in two shared memory areas: one in I420 format and one in ARGB format." << std::endl;
-        std::cerr << "Usage:   " << argv[0] << " --camera=<identifier> --width=<width> --height=<height> [--name.i420=<unique name for the shared memory in I420 format>] [--name.argb=<unique name for the shared memory in ARGB format>] --width=W --height=H [--offsetX=X] [--offsetY=Y] [--packetsize=1500] [--fps=17] [--skip.argb] [--verbose]" << std::endl;
-        std::cerr << "         --camera:     Identifier of Spinnaker-compatible camera to be used" << std::endl;
-        std::cerr << "         --name.i420:  name of the shared memory for the I420 formatted image; when omitted, 'video0.i420' is chosen" << std::endl;
-        std::cerr << "         --name.argb:  name of the shared memory for the I420 formatted image; when omitted, 'video0.argb' is chosen" << std::endl;
+        std::cerr << argv[0] << " interfaces with one or more Spinnaker cameras (given by their serial numbers) and provides the captured images in two shared memory areas per camera: one in I420 format and one in ARGB format." << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " --camera=<serial>[,<serial>...] --width=<width>[,...] --height=<height>[,...] [--name.i420=<unique name for the shared memory in I420 format>[,...]] [--name.argb=<unique name for the shared memory in ARGB format>[,...]] [--name.native=<unique name for the shared memory in the camera's native format>[,...]] [--native.buffers=8] [--publish=lock|ring|seqlock] [--ring.slots=3] [--offsetX=X[,...]] [--offsetY=Y[,...]] [--packetsize=1500|auto] [--packetdelay=<ticks>|auto] [--fps=17] [--acquisition=poll|event] [--queue.size=3] [--queue.drop=oldest|newest] [--conversion.threads=1] [--conversion.affinity=<list of CPUs>] [--pixelformat=yuv422|mono8|mono12p|mono16|bayer|bayer12p] [--demosaic=bilinear|edge] [--name.hdr=<unique name for the shared memory with 16-bit frames>[,...]] [--tonemap=linear|log] [--tonemap.lut=<file>] [--outputs=i420,argb[,nv12,bgr24,rgb24,rgbp,uyvy]] [--name.<output>=<unique name for the shared memory of an additional output format>[,...]] [--skip.argb] [--pyramid=<levels>] [--crops=WxH+X+Y[@WxH][,...]] [--crop.names=<name>[,...]] [--reader.timeout=<ms>] [--tensor=WxH] [--tensor.type=fp32|fp16|uint8] [--tensor.mean=r,g,b] [--tensor.std=r,g,b] [--tensor.order=rgb|bgr] [--tensor.resize=letterbox|stretch] [--tensor.pad=114] [--name.tensor=<unique name for the shared memory with the tensor>[,...]] [--calibration=<file>[,...]] [--nochunkdata] [--trigger=off|master|external] [--trigger.output=Line1] [--trigger.input=Line3] [--name.set=<unique name for the shared memory with synchronized I420 frame sets>] [--sync.key=timestamp|frameid] [--sync.tolerance=5] [--bandwidth.link=<Mbit/s>] [--bandwidth.headroom=0.1] [--discovery.timeout=5000] [--discovery.cache=<file>] [--statistics.period=1] [--cid=<OD4 session>] [--id=<sender stamp>] [--verbose]" << std::endl;
+        std::cerr << "         --camera:     comma-separated serial numbers of the Spinnaker-compatible cameras to be used; all cameras are handled in this process" << std::endl;
+        std::cerr << "                       --width, --height, --offsetX, --offsetY, and --fps take one value per camera; the last value applies to all further cameras" << std::endl;
+        std::cerr << "         --name.i420:  names of the shared memory for the I420 formatted images; when omitted, 'video<i>.i420' is chosen for the i-th camera" << std::endl;
+        std::cerr << "         --name.argb:  names of the shared memory for the ARGB formatted images; when omitted, 'video<i>.argb' is chosen for the i-th camera" << std::endl;
+        std::cerr << "         --name.native: names of the shared memory that the cameras write their UYVY, Mono8, or Bayer frames to directly; when omitted, no such area is created" << std::endl;
+        std::cerr << "         --native.buffers: number of camera stream buffers in the native shared memory (default: 8)" << std::endl;
+        std::cerr << "         --publish:    publish I420/ARGB frames under the shared memory's lock, in a ring of slots, or in place guarded by a sequence counter; readers access the latter two without locking (default: lock)" << std::endl;
+        std::cerr << "         --ring.slots: number of slots per shared memory for --publish=ring (default: 3)" << std::endl;
         std::cerr << "         --width:      desired width of a frame" << std::endl;
         std::cerr << "         --height:     desired height of a frame" << std::endl;
         std::cerr << "         --offsetX:    X for desired ROI (default: 0)" << std::endl;
         std::cerr << "         --offsetY:    Y for desired ROI (default: 0)" << std::endl;
         std::cerr << "         --fps:        desired acquisition frame rate (depends on bandwidth)" << std::endl;
-        std::cerr << "         --monochrome: monochrome (mono8) input frame" << std::endl;
-        std::cerr << "         --skip.argb:  do not transform image to ARGB" << std::endl;
+        std::cerr << "         --packetsize: GigE packet size in bytes, or auto for the largest size (e.g., jumbo frames) that the network path supports (default: camera setting)" << std::endl;
+        std::cerr << "         --packetdelay: GigE inter-packet delay in ticks, or auto to raise it while packets are lost and lower it again afterwards (default: camera setting)" << std::endl;
+        std::cerr << "         --acquisition: poll frames from a dedicated thread or receive them via image events (default: poll)" << std::endl;
+        std::cerr << "         --queue.size: number of frames buffered between acquisition and conversion (default: 3)" << std::endl;
+        std::cerr << "         --queue.drop: frame to discard when the queue is full: oldest or newest (default: oldest)" << std::endl;
+        std::cerr << "         --conversion.threads: number of threads converting a frame in horizontal stripes; shared by all cameras (default: 1)" << std::endl;
+        std::cerr << "         --conversion.affinity: comma-separated list of CPUs to pin the conversion threads to; the calling thread of each camera may run on all of them, and the further threads of --conversion.threads are pinned to the second, third, ... CPU in turn (default: none)" << std::endl;
+        std::cerr << "         --pixelformat: pixel format on the wire: yuv422 (2 bytes per pixel), mono8, bayer (raw 8-bit Bayer, 1 byte per pixel, demosaiced on the host), or the high bit depth formats mono12p, mono16, and bayer12p, which are tone mapped to 8 bits (default: yuv422)" << std::endl;
+        std::cerr << "         --demosaic:   interpolation of Bayer frames: bilinear, or edge for edge-aware interpolation (default: bilinear)" << std::endl;
+        std::cerr << "         --name.hdr:   names of the shared memory for the unpacked 16-bit frames of high bit depth formats; when omitted, no such area is created" << std::endl;
+        std::cerr << "         --tonemap:    mapping of high bit depth frames to the 8-bit outputs: linear or log (default: linear)" << std::endl;
+        std::cerr << "         --tonemap.lut: file with 4096 values from 0 to 255 that map the upper 12 bits of a 16-bit sample; overrides --tonemap" << std::endl;
+        std::cerr << "         --monochrome: monochrome (mono8) input frame; same as --pixelformat=mono8" << std::endl;
+        std::cerr << "         --outputs:    output formats, each in its own shared memory: i420 (always produced), argb, nv12, bgr24 (B, G, R in memory), rgb24 (R, G, B in memory), rgbp (R, G, and B planes), uyvy (copy of the yuv422 camera frames) (default: i420,argb)" << std::endl;
+        std::cerr << "         --name.<output>: names of the shared memory for an output format of --outputs other than i420 and argb, e.g., --name.nv12; when omitted, video<i>.<output> is chosen for the i-th camera" << std::endl;
+        std::cerr << "         --skip.argb:  do not transform image to ARGB; same as leaving argb out of --outputs" << std::endl;
+        std::cerr << "         --pyramid:    number of pyramid levels below the full resolution, each of half the width and height of the level above, published in I420 and ARGB format in the shared memory <name.i420>.<level> and <name.argb>.<level>; at most 4 (default: 0)" << std::endl;
+        std::cerr << "         --crops:      regions of all cameras' frames to publish on their own, each as WxH+X+Y with an optional output size @WxH to resample the region to; positions and sizes are rounded down to even values; at most 8" << std::endl;
+        std::cerr << "         --crop.names: names of the crops; a crop is published in I420 and ARGB format in the shared memory <name.i420>.<crop name> and <name.argb>.<crop name> (default: crop<k> for the k-th crop)" << std::endl;
+        std::cerr << "         --tensor:     size WxH of the planes of a tensor resampled from the ARGB frames for inference, published as three planes (R, G, B) of WxH values" << std::endl;
+        std::cerr << "         --tensor.type: type of the tensor's values: fp32, fp16, or the unnormalised pixels as uint8 (default: fp32)" << std::endl;
+        std::cerr << "         --tensor.mean: means of the R, G, and B values in the range of 0 to 1 that are subtracted from the values (default: 0,0,0)" << std::endl;
+        std::cerr << "         --tensor.std: standard deviations of the R, G, and B values in the range of 0 to 1 that the values are divided by (default: 1,1,1)" << std::endl;
+        std::cerr << "         --tensor.order: order of the tensor's planes (default: rgb)" << std::endl;
+        std::cerr << "         --tensor.resize: keep the aspect ratio and pad the borders (letterbox) or stretch the frames to the tensor's size (default: letterbox)" << std::endl;
+        std::cerr << "         --tensor.pad: pixel value from 0 to 255 of the padding of letterboxed tensors (default: 114)" << std::endl;
+        std::cerr << "         --name.tensor: names of the shared memory for the tensors; when omitted, 'video<i>.tensor' is chosen for the i-th camera" << std::endl;
+        std::cerr << "         --calibration: calibration files of the cameras with the lines 'size W H', 'K fx fy cx cy', 'D k1 k2 p1 p2 [k3]', and optionally 'R r11 ... r33' and 'P fx fy cx cy'; the undistorted or rectified frames are published in I420 and ARGB format in the shared memory <name.i420>.undistorted and <name.argb>.undistorted (default: none)" << std::endl;
+        std::cerr << "         --reader.timeout: milliseconds after the last heartbeat of a registered reader (cf. shared-memory-layout.hpp) until an output is no longer produced; 0 to always produce all outputs (default: 0)" << std::endl;
         std::cerr << "         --nocameratimestamp:  do not use timestamp from camera but the local time" << std::endl;
+        std::cerr << "         --nochunkdata:  do not enable chunk data (frame ID, time stamp, exposure time, gain) for per-frame metadata" << std::endl;
+        std::cerr << "         --trigger:    off: all cameras run freely; master: the first camera triggers all others via --trigger.output; external: all cameras are triggered via --trigger.input (default: off)" << std::endl;
+        std::cerr << "         --trigger.output: output line of the master camera (default: Line1)" << std::endl;
+        std::cerr << "         --trigger.input: trigger input line of the triggered cameras (default: Line3)" << std::endl;
+        std::cerr << "         --name.set:   name of the shared memory in which the I420 frames of all cameras are published as one set once all frames of a trigger have arrived; requires the same size for all cameras (default: none)" << std::endl;
+        std::cerr << "         --sync.key:   match the frames of a set by camera time stamp (requires PTP) or by frame ID relative to each camera's first frame (default: timestamp)" << std::endl;
+        std::cerr << "         --sync.tolerance: maximum difference in milliseconds of the camera time stamps within a set (default: 5)" << std::endl;
+        std::cerr << "         --bandwidth.link: capacity in Mbit/s of each network interface; when given, the throughput of the cameras sharing an interface is limited to fit it, the acquisition starts of free-running cameras are staggered over their frame period (re-applied when a camera restarts; the phases drift apart with the cameras' clocks in between), and the service stops if they cannot fit (default: none)" << std::endl;
+        std::cerr << "         --bandwidth.headroom: fraction of the link capacity that is kept free (default: 0.1)" << std::endl;
+        std::cerr << "         --discovery.timeout: maximum time in milliseconds to wait for the cameras to show up on the interfaces, which are polled in parallel (default: 5000)" << std::endl;
+        std::cerr << "         --discovery.cache: file to remember the interface of each camera in; these interfaces are polled first on the next start (default: none)" << std::endl;
+        std::cerr << "         --statistics.period: seconds between two stream statistics reports (frames, incomplete frames, frame ID gaps, queue drops, buffer underruns, lost packets); 0 to disable (default: 1)" << std::endl;
+        std::cerr << "         --cid:        CID of the OD4Session to send the stream statistics as NetworkStatusMessage and the startup time as SystemOperationState to (default: none)" << std::endl;
+        std::cerr << "         --id:         sender stamp of the NetworkStatusMessage of the first camera; the i-th camera uses id + i (default: 0)" << std::endl;
         std::cerr << "         --verbose:    display captured image" << std::endl;
         std::cerr << "         --debug:      debug output" << std::endl;
         std::cerr << "Example: " << argv[0] << " --camera=0 --width=640 --height=480 --verbose" << std::endl;
         retCode = 1;
     } else {
-        const uint32_t CAMERA{static_cast<uint32_t>(std::stoi(commandlineArguments["camera"]))};
-        const uint32_t WIDTH{static_cast<uint32_t>(std::stoi(commandlineArguments["width"]))};
-        const uint32_t HEIGHT{static_cast<uint32_t>(std::stoi(commandlineArguments["height"]))};
-        const uint32_t OFFSET_X{static_cast<uint32_t>((commandlineArguments.count("offsetX") != 0) ? std::stoi(commandlineArguments["offsetX"]) : 0)};
-        const uint32_t OFFSET_Y{static_cast<uint32_t>((commandlineArguments.count("offsetY") != 0) ? std::stoi(commandlineArguments["offsetY"]) : 0)};
-        const float FPS{static_cast<float>((commandlineArguments.count("fps") != 0) ? std::stof(commandlineArguments["fps"]) : 17)};
-        const bool SKIP_ARGB{commandlineArguments.count("skip.argb") != 0};
+        std::vector<uint32_t> CAMERAS;
+        for (auto camera : splitList(commandlineArguments["camera"])) {
+            CAMERAS.push_back(static_cast<uint32_t>(std::stoul(camera)));
+        }
+        const std::vector<std::string> WIDTHS{splitList(commandlineArguments["width"])};
+        const std::vector<std::string> HEIGHTS{splitList(commandlineArguments["height"])};
+        const std::vector<std::string> OFFSETS_X{splitList(commandlineArguments["offsetX"])};
+        const std::vector<std::string> OFFSETS_Y{splitList(commandlineArguments["offsetY"])};
+        const std::vector<std::string> FPS{splitList(commandlineArguments["fps"])};
+        const std::vector<std::string> NAMES_I420{splitList(commandlineArguments["name.i420"])};
+        const std::vector<std::string> NAMES_ARGB{splitList(commandlineArguments["name.argb"])};
+        const std::vector<std::string> NAMES_NATIVE{splitList(commandlineArguments["name.native"])};
+        const std::vector<std::string> NAMES_HDR{splitList(commandlineArguments["name.hdr"])};
+        const std::vector<std::string> NAMES_TENSOR{splitList(commandlineArguments["name.tensor"])};
+        const std::vector<std::string> CALIBRATIONS{splitList(commandlineArguments["calibration"])};
+        const uint32_t QUEUE_SIZE{static_cast<uint32_t>((commandlineArguments.count("queue.size") != 0) ? std::stoi(commandlineArguments["queue.size"]) : 3)};
+        const auto QUEUE_DROP_POLICY{FrameQueue<Frame>::dropPolicyFromString(commandlineArguments["queue.drop"])};
+        const uint32_t CONVERSION_THREADS{static_cast<uint32_t>((commandlineArguments.count("conversion.threads") != 0) ? std::max(1, std::stoi(commandlineArguments["conversion.threads"])) : 1)};
+        std::vector<int32_t> CONVERSION_AFFINITY;
+        if (commandlineArguments["conversion.affinity"].size() != 0) {
+            for (auto cpu : splitList(commandlineArguments["conversion.affinity"])) {
+                CONVERSION_AFFINITY.push_back(std::stoi(cpu));
+            }
+        }
+        const bool EVENT_ACQUISITION{"event" == commandlineArguments["acquisition"]};
+        const std::vector<std::string> OUTPUTS{splitList((commandlineArguments.count("outputs") != 0) ? commandlineArguments["outputs"] : "i420,argb")};
+        const bool SKIP_ARGB{(commandlineArguments.count("skip.argb") != 0) || (OUTPUTS.end() == std::find(OUTPUTS.begin(), OUTPUTS.end(), "argb"))};
+        const uint32_t PYRAMID_LEVELS{static_cast<uint32_t>((commandlineArguments.count("pyramid") != 0) ? std::stoi(commandlineArguments["pyramid"]) : 0)};
+        const std::vector<std::string> CROPS{splitList(commandlineArguments["crops"])};
+        const std::vector<std::string> CROP_NAMES{splitList(commandlineArguments["crop.names"])};
+        const uint32_t READER_TIMEOUT{static_cast<uint32_t>((commandlineArguments.count("reader.timeout") != 0) ? std::stoi(commandlineArguments["reader.timeout"]) : 0)};
         const bool NOCAMERATIMESTAMP{commandlineArguments.count("nocameratimestamp") != 0};
-        const bool MONO8{commandlineArguments.count("monochrome") != 0};
+        const bool NOCHUNKDATA{commandlineArguments.count("nochunkdata") != 0};
+        const std::string PIXEL_FORMAT{(commandlineArguments.count("monochrome") != 0) ? "mono8" : commandlineArguments["pixelformat"]};
+        const CameraPipeline::PixelFormat CAMERA_PIXEL_FORMAT{("mono8" == PIXEL_FORMAT) ? CameraPipeline::PixelFormat::MONO8
+                                                           : ("mono12p" == PIXEL_FORMAT) ? CameraPipeline::PixelFormat::MONO12P
+                                                           : ("mono16" == PIXEL_FORMAT) ? CameraPipeline::PixelFormat::MONO16
+                                                           : ("bayer" == PIXEL_FORMAT) ? CameraPipeline::PixelFormat::BAYER8
+                                                           : ("bayer12p" == PIXEL_FORMAT) ? CameraPipeline::PixelFormat::BAYER12P
+                                                           : CameraPipeline::PixelFormat::YUV422};
+        const kernels::Demosaic DEMOSAIC{("edge" == commandlineArguments["demosaic"]) ? kernels::Demosaic::EDGE_AWARE : kernels::Demosaic::BILINEAR};
         const bool VERBOSE{commandlineArguments.count("verbose") != 0};
         const bool DEBUG{commandlineArguments.count("debug") != 0};
-
-        // Set up the names for the shared memory areas.
-        std::string NAME_I420{"video0.i420"};
-        if ((commandlineArguments["name.i420"].size() != 0)) {
-            NAME_I420 = commandlineArguments["name.i420"];
-        }
-        std::string NAME_ARGB{"video0.argb"};
-        if ((commandlineArguments["name.argb"].size() != 0)) {
-            NAME_ARGB = commandlineArguments["name.argb"];
-        }
-
-        std::unique_ptr<cluon::SharedMemory> sharedMemoryI420(new cluon::SharedMemory{NAME_I420, WIDTH * HEIGHT * 3 / 2});
-        if (!sharedMemoryI420 || !sharedMemoryI420->valid()) {
-            std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << NAME_I420 << "'." << std::endl;
+        const uint32_t STATISTICS_PERIOD{static_cast<uint32_t>((commandlineArguments.count("statistics.period") != 0) ? std::stoi(commandlineArguments["statistics.period"]) : 1)};
+        const uint32_t ID{static_cast<uint32_t>((commandlineArguments.count("id") != 0) ? std::stoi(commandlineArguments["id"]) : 0)};
+        const uint32_t NATIVE_BUFFERS{static_cast<uint32_t>((commandlineArguments.count("native.buffers") != 0) ? std::stoi(commandlineArguments["native.buffers"]) : 8)};
+        const SharedMemoryArea::Mode PUBLISH_MODE{SharedMemoryArea::modeFromString(commandlineArguments["publish"])};
+        const uint32_t RING_SLOTS{static_cast<uint32_t>((commandlineArguments.count("ring.slots") != 0) ? std::stoi(commandlineArguments["ring.slots"]) : 3)};
+        const std::string TRIGGER{commandlineArguments["trigger"]};
+        const std::string TRIGGER_OUTPUT{(commandlineArguments.count("trigger.output") != 0) ? commandlineArguments["trigger.output"] : "Line1"};
+        const std::string TRIGGER_INPUT{(commandlineArguments.count("trigger.input") != 0) ? commandlineArguments["trigger.input"] : "Line3"};
+        const std::string NAME_SET{commandlineArguments["name.set"]};
+        const bool AUTO_PACKET_SIZE{"auto" == commandlineArguments["packetsize"]};
+        const int64_t PACKET_SIZE{((commandlineArguments.count("packetsize") != 0) && !AUTO_PACKET_SIZE) ? std::stoll(commandlineArguments["packetsize"]) : 0};
+        const bool AUTO_PACKET_DELAY{"auto" == commandlineArguments["packetdelay"]};
+        const int64_t PACKET_DELAY{((commandlineArguments.count("packetdelay") != 0) && !AUTO_PACKET_DELAY) ? std::stoll(commandlineArguments["packetdelay"]) : -1};
+        const uint32_t DISCOVERY_TIMEOUT{static_cast<uint32_t>((commandlineArguments.count("discovery.timeout") != 0) ? std::stoi(commandlineArguments["discovery.timeout"]) : 5000)};
+        const std::string DISCOVERY_CACHE{commandlineArguments["discovery.cache"]};
+        const double LINK_CAPACITY{((commandlineArguments.count("bandwidth.link") != 0) ? std::stod(commandlineArguments["bandwidth.link"]) : 0.0) * 1000000.0 / 8.0};
+        const double HEADROOM{(commandlineArguments.count("bandwidth.headroom") != 0) ? std::stod(commandlineArguments["bandwidth.headroom"]) : 0.1};
+        const FrameSetArea::Key SYNC_KEY{FrameSetArea::keyFromString(commandlineArguments["sync.key"])};
+        const float SYNC_TOLERANCE{static_cast<float>((commandlineArguments.count("sync.tolerance") != 0) ? std::stof(commandlineArguments["sync.tolerance"]) : 5)};
+        // High bit depth frames are mapped to 8 bits through one table for all cameras.
+        std::unique_ptr<ToneMap> toneMap{(commandlineArguments.count("tonemap.lut") != 0) ? new ToneMap{commandlineArguments["tonemap.lut"]} : new ToneMap{ToneMap::curveFromString(commandlineArguments["tonemap"])}};
+        if (!toneMap->valid()) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Failed to read " << ToneMap::SIZE << " values from 0 to 255 from '" << commandlineArguments["tonemap.lut"] << "'." << std::endl;
             return retCode = 1;
         }
-
-        std::unique_ptr<cluon::SharedMemory> sharedMemoryARGB(new cluon::SharedMemory{NAME_ARGB, WIDTH * HEIGHT * 4});
-        if (!sharedMemoryARGB || !sharedMemoryARGB->valid()) {
-            std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << NAME_ARGB << "'." << std::endl;
-            return retCode = 1;
+        // Formats other than I420 and ARGB get areas of their own.
+        std::vector<std::pair<CameraPipeline::OutputFormat, std::string>> outputFormats;
+        for (const auto &output : OUTPUTS) {
+            CameraPipeline::OutputFormat outputFormat;
+            if (("i420" == output) || ("argb" == output)) {
+                continue;
+            }
+            if (!CameraPipeline::outputFormatFromString(output, outputFormat)) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Unknown output format '" << output << "'." << std::endl;
+                return retCode = 1;
+            }
+            if (outputFormats.end() == std::find_if(outputFormats.begin(), outputFormats.end(), [&output](const std::pair<CameraPipeline::OutputFormat, std::string> &entry) { return output == entry.second; })) {
+                outputFormats.emplace_back(outputFormat, output);
+            }
         }
-
-        if ((sharedMemoryI420 && sharedMemoryI420->valid()) && (sharedMemoryARGB && sharedMemoryARGB->valid())) {
-            std::clog << "[opendlv-device-camera-spinnaker]: Data from camera '" << commandlineArguments["camera"] << "' available in I420 format in shared memory '" << sharedMemoryI420->name() << "' (" << sharedMemoryI420->size() << ") and in ARGB format in shared memory '" << sharedMemoryARGB->name() << "' (" << sharedMemoryARGB->size() << ")." << std::endl;
-
-            // Open desired camera.
-            Spinnaker::SystemPtr system{Spinnaker::System::GetInstance()};
-            Spinnaker::InterfaceList listOfInterfaces{system->GetInterfaces()};
-            Spinnaker::CameraPtr camera{nullptr};
-            {
-                Spinnaker::InterfacePtr interfacePtr{nullptr};
-                for(uint32_t i{0}; i < listOfInterfaces.GetSize(); i++) {
-                    interfacePtr = listOfInterfaces.GetByIndex(i);
-                    interfacePtr->UpdateCameras();
-                    {
-                        using namespace std::literals::chrono_literals;
-                        std::this_thread::sleep_for(1s);
-                    }
-                    {
-                        Spinnaker::CameraList listOfCameras{interfacePtr->GetCameras()};
-                        for(uint32_t j{0}; j < listOfCameras.GetSize(); j++) {
-                            try {
-                                Spinnaker::CameraPtr cam{listOfCameras.GetByIndex(j)};
-                                Spinnaker::GenApi::INodeMap &cameraNodeMap{cam->GetTLDeviceNodeMap()};
-                                Spinnaker::GenApi::CStringPtr ptrDeviceSerialNumber{cameraNodeMap.GetNode("DeviceSerialNumber")};
-                                if (Spinnaker::GenApi::IsAvailable(ptrDeviceSerialNumber) && Spinnaker::GenApi::IsReadable(ptrDeviceSerialNumber)) {
-                                    std::string serialNumber{ptrDeviceSerialNumber->ToString()};
-                                    std::cout << "Serial Number: " << serialNumber << std::endl;
-                                    uint32_t foundSerialNumber{static_cast<uint32_t>(std::stoi(serialNumber))};
-                                    if (CAMERA == foundSerialNumber) {
-                                        camera = cam;
-                                        camera->Init();
-                                        std::cerr << "Found " << foundSerialNumber << " on interface " << i << std::endl;
-                                        break;
-                                    }
-                                }
-                            }
-                            catch (...) {
-                                camera = nullptr;
-                            }
-                        }
-                    }
-                }
+        std::vector<FrameConverter::Crop> crops;
+        for (const auto &entry : CROPS) {
+            FrameConverter::Crop crop;
+            if (!parseCrop(entry, crop)) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Crop '" << entry << "' is not of the form WxH+X+Y[@WxH]." << std::endl;
+                return retCode = 1;
             }
-            if (nullptr == camera) {
-                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to open camera '" << CAMERA << "'." << std::endl;
+            crops.push_back(crop);
+        }
+        FrameConverter::Tensor tensor;
+        if (commandlineArguments.count("tensor") != 0) {
+            char end{0};
+            if ((2 != std::sscanf(commandlineArguments["tensor"].c_str(), "%ux%u%c", &tensor.width, &tensor.height, &end)) || (0 == tensor.width) || (0 == tensor.height)) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Tensor size '" << commandlineArguments["tensor"] << "' is not of the form WxH." << std::endl;
                 return retCode = 1;
             }
-
-            Spinnaker::GenApi::INodeMap &cameraNodeMap{camera->GetTLDeviceNodeMap()};
-            {
-                Spinnaker::GenApi::FeatureList_t features;
-                Spinnaker::GenApi::CCategoryPtr category{cameraNodeMap.GetNode("DeviceInformation")};
-                if (Spinnaker::GenApi::IsAvailable(category) && Spinnaker::GenApi::IsReadable(category)) {
-                    category->GetFeatures(features);
-                    for (auto it = features.begin(); it != features.end(); it++) {
-                        Spinnaker::GenApi::CNodePtr featureNode{*it};
-                        std::clog << "  " << featureNode->GetName() << ": ";
-                        Spinnaker::GenApi::CValuePtr valuePtr = (Spinnaker::GenApi::CValuePtr)featureNode;
-                        std::clog << (Spinnaker::GenApi::IsReadable(valuePtr) ? valuePtr->ToString() : "Node not readable");
-                        std::clog << std::endl;
-                    }
-                } else {
-                    std::cerr << "[opendlv-device-camera-spinnaker]: Could not read device control information." << std::endl;
-                }
+            const std::string TYPE{commandlineArguments["tensor.type"]};
+            tensor.type      = ("fp16" == TYPE) ? kernels::TensorType::FLOAT16 : (("uint8" == TYPE) ? kernels::TensorType::UINT8 : kernels::TensorType::FLOAT32);
+            tensor.bgr       = ("bgr" == commandlineArguments["tensor.order"]);
+            tensor.letterbox = ("stretch" != commandlineArguments["tensor.resize"]);
+            tensor.pad       = static_cast<uint8_t>((commandlineArguments.count("tensor.pad") != 0) ? std::stoi(commandlineArguments["tensor.pad"]) : 114);
+            if (((commandlineArguments.count("tensor.mean") != 0) && !parseRGB(commandlineArguments["tensor.mean"], tensor.mean))
+                || ((commandlineArguments.count("tensor.std") != 0) && !parseRGB(commandlineArguments["tensor.std"], tensor.std))) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: --tensor.mean and --tensor.std must be of the form r,g,b." << std::endl;
+                return retCode = 1;
             }
-
-            // Disable trigger mode.
-            {
-                if (Spinnaker::GenApi::RW != camera->TriggerMode.GetAccessMode()) {
-                    std::cerr << "[opendlv-device-camera-spinnaker]: Could not disable trigger mode." << std::endl;
-                    return retCode = 1;
-                }
-                camera->TriggerMode.SetValue(Spinnaker::TriggerModeEnums::TriggerMode_Off);
+        }
+        // Calibrations are read once; a camera without one has no undistorted outputs.
+        std::vector<RemapTable::Calibration> calibrations;
+        for (const auto &file : CALIBRATIONS) {
+            RemapTable::Calibration calibration;
+            if (!RemapTable::readCalibration(file, calibration)) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to read a calibration from '" << file << "'." << std::endl;
+                return retCode = 1;
             }
+            calibrations.push_back(calibration);
+        }
+        if (!NAMES_NATIVE.empty() && EVENT_ACQUISITION) {
+            std::cerr << "[opendlv-device-camera-spinnaker]: Image events deliver copies of the camera buffers; using --acquisition=poll for --name.native." << std::endl;
+        }
 
-            Spinnaker::GenApi::INodeMap &nodeMap              = camera->GetNodeMap();
-            Spinnaker::GenApi::CEnumerationPtr ptrPixelFormat = nodeMap.GetNode("PixelFormat");
-            if (IsAvailable(ptrPixelFormat) && IsWritable(ptrPixelFormat)) {
-                // Retrieve the desired entry node from the enumeration node
-                if (MONO8) {
-                    Spinnaker::GenApi::CEnumEntryPtr ptrPixelFormatYUV = ptrPixelFormat->GetEntryByName("Mono8");
-                    if (IsAvailable(ptrPixelFormatYUV) && IsReadable(ptrPixelFormatYUV)) {
-                        // Retrieve the integer value from the entry node:
-                        int64_t pixelFormatYUV = ptrPixelFormatYUV->GetValue();
-
-                        // Set integer as new value for enumeration node
-                        ptrPixelFormat->SetIntValue(pixelFormatYUV);
-
-                        std::clog << "[opendlv-device-camera-spinnaker]: Pixel format set to " << ptrPixelFormat->GetCurrentEntry()->GetSymbolic() << "." << std::endl;
-                    } else {
-                        std::cerr << "[opendlv-device-camera-spinnaker]: Error: Pixel format MONO8 not available." << std::endl;
-                    }
-                }
-                else {
-                    Spinnaker::GenApi::CEnumEntryPtr ptrPixelFormatYUV = ptrPixelFormat->GetEntryByName("YUV422Packed");
-                    if (IsAvailable(ptrPixelFormatYUV) && IsReadable(ptrPixelFormatYUV)) {
-                        // Retrieve the integer value from the entry node:
-                        int64_t pixelFormatYUV = ptrPixelFormatYUV->GetValue();
-
-                        // Set integer as new value for enumeration node
-                        ptrPixelFormat->SetIntValue(pixelFormatYUV);
-
-                        std::clog << "[opendlv-device-camera-spinnaker]: Pixel format set to " << ptrPixelFormat->GetCurrentEntry()->GetSymbolic() << "." << std::endl;
-                    } else {
-                        std::cerr << "[opendlv-device-camera-spinnaker]: Error: Pixel format YUV422Packed not available." << std::endl;
-                    }
-                }
-            } else {
-                std::cerr << "[opendlv-device-camera-spinnaker]: Error: Pixel format not available." << std::endl;
-            }
+        // Stream statistics of all cameras are sent to the same OD4Session.
+        std::unique_ptr<cluon::OD4Session> od4{nullptr};
+        if (0 != commandlineArguments.count("cid")) {
+            od4.reset(new cluon::OD4Session{static_cast<uint16_t>(std::stoi(commandlineArguments["cid"]))});
+        }
 
-            // Disable auto frame rate.
-            try {
-                Spinnaker::GenApi::CBooleanPtr acquisitionFrameRateEnable = nodeMap.GetNode("AcquisitionFrameRateEnable");
-                if (IsAvailable(acquisitionFrameRateEnable) && IsReadable(acquisitionFrameRateEnable)) {
-                    acquisitionFrameRateEnable->SetValue(1);
-                    camera->AcquisitionFrameRate.SetValue(FPS);
-                } else {
-                    std::cerr << "[opendlv-device-camera-spinnaker]: Could not disable frame rate." << std::endl;
+        // The I420 frames of all cameras belonging to the same trigger are published together.
+        std::unique_ptr<FrameSetArea> frameSetArea{nullptr};
+        if (!NAME_SET.empty()) {
+            const uint32_t WIDTH{static_cast<uint32_t>(std::stoi(entryFor(WIDTHS, 0, "0")))};
+            const uint32_t HEIGHT{static_cast<uint32_t>(std::stoi(entryFor(HEIGHTS, 0, "0")))};
+            for (uint32_t i{1}; i < CAMERAS.size(); i++) {
+                if ((WIDTH != static_cast<uint32_t>(std::stoi(entryFor(WIDTHS, i, "0")))) || (HEIGHT != static_cast<uint32_t>(std::stoi(entryFor(HEIGHTS, i, "0"))))) {
+                    std::cerr << "[opendlv-device-camera-spinnaker]: All cameras must have the same size for --name.set." << std::endl;
+                    return retCode = 1;
                 }
             }
-            catch (...) {
-                std::cerr << "[opendlv-device-camera-spinnaker]: Could not set frame rate." << std::endl;
+            frameSetArea.reset(new FrameSetArea{NAME_SET, static_cast<uint32_t>(CAMERAS.size()), WIDTH * HEIGHT * 3 / 2, WIDTH, HEIGHT, layout::fourcc('I', '4', '2', '0'), std::max(RING_SLOTS, 4u), SYNC_KEY, static_cast<int64_t>(SYNC_TOLERANCE * 1000000.0f)});
+            if (!frameSetArea->valid()) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Failed to create shared memory '" << NAME_SET << "'." << std::endl;
+                return retCode = 1;
             }
+            std::clog << "[opendlv-device-camera-spinnaker]: Frame sets of " << CAMERAS.size() << " cameras available in I420 format in shared memory '" << frameSetArea->name() << "' (" << frameSetArea->size() << ")." << std::endl;
+        }
 
-            // Enable auto exposure.
-            camera->ExposureAuto.SetValue(Spinnaker::ExposureAutoEnums::ExposureAuto_Continuous);
-
-            // Enable auto gain.
-            camera->GainAuto.SetValue(Spinnaker::GainAutoEnums::GainAuto_Continuous);
+        // Frames of all cameras are converted in stripes on one persistent pool of threads.
+        WorkerPool workerPool{CONVERSION_THREADS, CONVERSION_AFFINITY};
 
-            // Enable auto white balance.
-            if (!MONO8) {
-                camera->BalanceWhiteAuto.SetValue(Spinnaker::BalanceWhiteAutoEnums::BalanceWhiteAuto_Continuous);
-            }
+        // Each camera window is updated from its own conversion thread.
+        if (VERBOSE) {
+            XInitThreads();
+        }
 
-            // Enable PTP.
+        // All cameras share one Spinnaker system; a lost camera is looked up
+        // by its serial number again.
+        Spinnaker::SystemPtr system{Spinnaker::System::GetInstance()};
+        Spinnaker::InterfaceList listOfInterfaces{system->GetInterfaces()};
+        std::mutex systemMutex;
+        auto findCamera = [&system, &systemMutex](uint32_t serialNumber) {
+            std::lock_guard<std::mutex> lck(systemMutex);
+            Spinnaker::CameraPtr camera{nullptr};
             try {
-                camera->GevIEEE1588.SetValue(true);
+                system->UpdateCameras();
+                Spinnaker::CameraList listOfCameras{system->GetCameras()};
+                camera = listOfCameras.GetBySerial(std::to_string(serialNumber));
             }
             catch (...) {
-                std::cerr << "[opendlv-device-camera-spinnaker]: Could not enable PTP." << std::endl;
+                camera = nullptr;
             }
-
-            // Define WIDTH, HEIGHT, OFFSETX, OFFSETY.
-            camera->Height.SetValue(HEIGHT);
-            camera->Width.SetValue(WIDTH);
-            camera->OffsetX.SetValue(OFFSET_X);
-            camera->OffsetY.SetValue(OFFSET_Y);
-
-            // Accessing the low-level X11 data display.
-            Display *display{nullptr};
-            Visual *visual{nullptr};
-            Window window{0};
-            XImage *ximage{nullptr};
-            if (VERBOSE) {
-                display = XOpenDisplay(NULL);
-                visual  = DefaultVisual(display, 0);
-                window  = XCreateSimpleWindow(display, RootWindow(display, 0), 0, 0, WIDTH, HEIGHT, 1, 0, 0);
-                sharedMemoryARGB->lock();
-                ximage = XCreateImage(display, visual, 24, ZPixmap, 0, sharedMemoryARGB->data(), WIDTH, HEIGHT, 32, 0);
-                sharedMemoryARGB->unlock();
-                XMapWindow(display, window);
+            return camera;
+        };
+
+        std::vector<std::unique_ptr<CameraPipeline>> pipelines;
+        for (uint32_t i{0}; i < CAMERAS.size(); i++) {
+            CameraPipeline::Configuration configuration;
+            configuration.index             = i;
+            configuration.serialNumber      = CAMERAS[i];
+            configuration.width             = static_cast<uint32_t>(std::stoi(entryFor(WIDTHS, i, "0")));
+            configuration.height            = static_cast<uint32_t>(std::stoi(entryFor(HEIGHTS, i, "0")));
+            configuration.offsetX           = static_cast<uint32_t>(std::stoi(entryFor(OFFSETS_X, i, "0")));
+            configuration.offsetY           = static_cast<uint32_t>(std::stoi(entryFor(OFFSETS_Y, i, "0")));
+            configuration.fps               = std::stof(entryFor(FPS, i, "17"));
+            configuration.nameI420          = (i < NAMES_I420.size()) ? NAMES_I420[i] : "video" + std::to_string(i) + ".i420";
+            configuration.nameARGB          = (i < NAMES_ARGB.size()) ? NAMES_ARGB[i] : "video" + std::to_string(i) + ".argb";
+            configuration.nameNative        = (i < NAMES_NATIVE.size()) ? NAMES_NATIVE[i] : "";
+            configuration.nameHDR           = (i < NAMES_HDR.size()) ? NAMES_HDR[i] : "";
+            configuration.nameTensor        = (i < NAMES_TENSOR.size()) ? NAMES_TENSOR[i] : "video" + std::to_string(i) + ".tensor";
+            for (const auto &outputFormat : outputFormats) {
+                const std::vector<std::string> NAMES{splitList(commandlineArguments["name." + outputFormat.second])};
+                CameraPipeline::Output output;
+                output.format = outputFormat.first;
+                output.name   = (i < NAMES.size()) ? NAMES[i] : "video" + std::to_string(i) + "." + outputFormat.second;
+                configuration.outputs.push_back(output);
             }
+            configuration.nativeBuffers     = NATIVE_BUFFERS;
+            configuration.publishMode       = PUBLISH_MODE;
+            configuration.ringSlots         = RING_SLOTS;
+            configuration.queueSize         = QUEUE_SIZE;
+            configuration.queueDropPolicy   = QUEUE_DROP_POLICY;
+            configuration.trigger           = ("external" == TRIGGER) ? CameraPipeline::Trigger::SLAVE
+                                            : ("master" == TRIGGER) ? ((0 == i) ? CameraPipeline::Trigger::MASTER : CameraPipeline::Trigger::SLAVE)
+                                            : CameraPipeline::Trigger::OFF;
+            configuration.triggerOutput     = TRIGGER_OUTPUT;
+            configuration.triggerInput      = TRIGGER_INPUT;
+            configuration.packetSize        = PACKET_SIZE;
+            configuration.autoPacketSize    = AUTO_PACKET_SIZE;
+            configuration.packetDelay       = PACKET_DELAY;
+            configuration.autoPacketDelay   = AUTO_PACKET_DELAY;
+            configuration.eventAcquisition  = EVENT_ACQUISITION && configuration.nameNative.empty();
+            configuration.skipARGB          = SKIP_ARGB;
+            configuration.pyramidLevels     = PYRAMID_LEVELS;
+            configuration.crops             = crops;
+            configuration.cropNames         = CROP_NAMES;
+            configuration.tensor            = tensor;
+            configuration.calibration       = (i < calibrations.size()) ? calibrations[i] : RemapTable::Calibration{};
+            configuration.readerTimeout     = READER_TIMEOUT;
+            configuration.noCameraTimestamp = NOCAMERATIMESTAMP;
+            configuration.noChunkData       = NOCHUNKDATA;
+            configuration.pixelFormat       = CAMERA_PIXEL_FORMAT;
+            configuration.demosaic          = DEMOSAIC;
+            configuration.toneMap           = toneMap->table();
+            configuration.verbose           = VERBOSE;
+            configuration.debug             = DEBUG;
+            configuration.statisticsPeriod  = STATISTICS_PERIOD;
+            configuration.senderStamp       = ID + i;
+            configuration.startTime         = START_TIME;
+            pipelines.emplace_back(new CameraPipeline{configuration, workerPool, od4.get(), frameSetArea.get(), findCamera});
+        }
 
-            // Start camera.
-            camera->AcquisitionMode.SetValue(Spinnaker::AcquisitionModeEnums::AcquisitionMode_Continuous);
-            camera->BeginAcquisition();
-
-            // Frame grabbing loop.
-            while (!cluon::TerminateHandler::instance().isTerminated.load()) {
-                Spinnaker::ImagePtr image{camera->GetNextImage()};
-                if ((Spinnaker::IMAGE_NO_ERROR == image->GetImageStatus()) && (image->GetTimeStamp() > 0)) {
-                    uint64_t imageTimestamp = image->GetTimeStamp();
-                    int width               = image->GetWidth();
-                    int height              = image->GetHeight();
+        // Open desired cameras.
+        std::vector<int64_t> startOffsets(pipelines.size(), -1);
+        {
+            const int64_t DISCOVERY_START{cluon::time::toMicroseconds(cluon::time::now())};
+            CameraDiscovery cameraDiscovery{listOfInterfaces, DISCOVERY_CACHE};
+            std::map<uint32_t, Spinnaker::CameraPtr> cameras{cameraDiscovery.find(CAMERAS, std::chrono::milliseconds(DISCOVERY_TIMEOUT))};
+            std::clog << "[opendlv-device-camera-spinnaker]: Found " << cameras.size() << " of " << CAMERAS.size() << " cameras on " << listOfInterfaces.GetSize() << " interfaces in " << (cluon::time::toMicroseconds(cluon::time::now()) - DISCOVERY_START) / 1000 << " ms." << std::endl;
+            for (auto &pipeline : pipelines) {
+                if (0 == cameras.count(pipeline->serialNumber())) {
+                    std::cerr << "[opendlv-device-camera-spinnaker]: Failed to open camera '" << pipeline->serialNumber() << "'." << std::endl;
+                    retCode = 1;
+                    break;
+                }
+                if (!pipeline->open(cameras[pipeline->serialNumber()])) {
+                    retCode = 1;
+                    break;
+                }
+            }
 
-                    if (DEBUG) {
-                        std::clog << "Grabbed frame of size " << width << "x" << height << " at " << imageTimestamp << std::endl;
-                    }
-                    cluon::data::TimeStamp ts{cluon::time::now()};
-                    if (!NOCAMERATIMESTAMP) {
-                        ts = cluon::time::fromMicroseconds(imageTimestamp/1000);
+            // Fit the cameras sharing an interface into its capacity.
+            if ((0 == retCode) && (0 < LINK_CAPACITY)) {
+                std::vector<BandwidthPlanner::Demand> demands;
+                for (auto &pipeline : pipelines) {
+                    BandwidthPlanner::Demand demand;
+                    demand.serialNumber = pipeline->serialNumber();
+                    demand.link         = cameraDiscovery.interfaceOf(pipeline->serialNumber());
+                    demand.required     = pipeline->requiredThroughput();
+                    demand.fps          = static_cast<double>(pipeline->configuration().fps);
+                    demands.push_back(demand);
+                }
+                BandwidthPlanner bandwidthPlanner{LINK_CAPACITY, HEADROOM};
+                std::vector<BandwidthPlanner::Allocation> allocations;
+                if (!bandwidthPlanner.plan(demands, allocations)) {
+                    std::cerr << "[opendlv-device-camera-spinnaker]: Requested cameras do not fit the network links; reduce the size, frame rate, or number of cameras per link:" << std::endl << bandwidthPlanner.report();
+                    retCode = 1;
+                } else {
+                    std::clog << "[opendlv-device-camera-spinnaker]: Bandwidth plan:" << std::endl << bandwidthPlanner.report();
+                    for (uint32_t i{0}; i < pipelines.size(); i++) {
+                        pipelines[i]->limitThroughput(allocations[i].limit, LINK_CAPACITY);
+                        // Triggered cameras expose at the same time by design.
+                        startOffsets[i] = (("master" != TRIGGER) && ("external" != TRIGGER)) ? allocations[i].startOffset : -1;
                     }
+                }
+            }
+        }
 
-                    if ((static_cast<uint32_t>(width) == WIDTH) && (static_cast<uint32_t>(height) == HEIGHT)) {
-                        sharedMemoryI420->lock();
-                        sharedMemoryI420->setTimeStamp(ts);
-                        if (MONO8) {
-                            libyuv::I400ToI420(reinterpret_cast<uint8_t *>(image->GetData()), WIDTH /* use monochrome channel only */,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data()), WIDTH,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT)), WIDTH / 2,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT + ((WIDTH * HEIGHT) >> 2))), WIDTH / 2,
-                                               WIDTH, HEIGHT);
-                        }
-                        else {
-                            libyuv::UYVYToI420(reinterpret_cast<uint8_t *>(image->GetData()), WIDTH * 2 /* 2*WIDTH for YUYV 422*/,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data()), WIDTH,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT)), WIDTH / 2,
-                                               reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT + ((WIDTH * HEIGHT) >> 2))), WIDTH / 2,
-                                               WIDTH, HEIGHT);
-                        }
-                        sharedMemoryI420->unlock();
-
-                        if (!SKIP_ARGB || VERBOSE) {
-                            sharedMemoryARGB->lock();
-                            sharedMemoryARGB->setTimeStamp(ts);
-                            {
-                                libyuv::I420ToARGB(reinterpret_cast<uint8_t *>(sharedMemoryI420->data()), WIDTH,
-                                                   reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT)), WIDTH / 2,
-                                                   reinterpret_cast<uint8_t *>(sharedMemoryI420->data() + (WIDTH * HEIGHT + ((WIDTH * HEIGHT) >> 2))), WIDTH / 2,
-                                                   reinterpret_cast<uint8_t *>(sharedMemoryARGB->data()), WIDTH * 4,
-                                                   WIDTH, HEIGHT);
-
-                                if (VERBOSE) {
-                                    XPutImage(display, window, DefaultGC(display, 0), ximage, 0, 0, 0, 0, WIDTH, HEIGHT);
-                                }
-                            }
-                            sharedMemoryARGB->unlock();
-                        }
-
-                        // Wake up any pending processes.
-                        sharedMemoryI420->notifyAll();
-                        sharedMemoryARGB->notifyAll();
+        // Forward the arrival and removal of cameras to their pipelines.
+        HotPlugEventHandler hotPlugEventHandler{[&pipelines](uint64_t serialNumber, bool arrived) {
+            for (auto &pipeline : pipelines) {
+                if (serialNumber == pipeline->serialNumber()) {
+                    std::clog << "[opendlv-device-camera-spinnaker]: Camera '" << serialNumber << "' " << (arrived ? "arrived." : "removed.") << std::endl;
+                    if (arrived) {
+                        pipeline->onDeviceArrival();
                     } else {
-                        std::cerr << "[opendlv-device-camera-spinnaker]: Grabbed frame of size " << width << "x" << height << " does not match size of shared memory!" << std::endl;
+                        pipeline->onDeviceRemoval();
                     }
                 }
-                image->Release();
             }
+        }};
 
-            camera->EndAcquisition();
+        if (0 == retCode) {
+            system->RegisterEventHandler(hotPlugEventHandler);
 
-            // Release any resources.
-            camera->DeInit();
-            listOfInterfaces.Clear();
-            system->ReleaseInstance();
+            // The master camera starts last so that all slaves see its first
+            // trigger; free-running cameras start, and restart after a
+            // recovery, at their planned offsets.
+            std::vector<uint32_t> startOrder;
+            for (uint32_t i{0}; i < pipelines.size(); i++) {
+                startOrder.insert(startOrder.begin(), i);
+            }
+            std::stable_sort(startOrder.begin(), startOrder.end(), [&startOffsets](uint32_t a, uint32_t b) { return startOffsets[a] < startOffsets[b]; });
+            const auto START{std::chrono::steady_clock::now()};
+            for (auto i : startOrder) {
+                pipelines[i]->setStartPhase(START, startOffsets[i]);
+                pipelines[i]->start();
+            }
+            while (!cluon::TerminateHandler::instance().isTerminated.load()) {
+                using namespace std::literals::chrono_literals;
+                std::this_thread::sleep_for(100ms);
+            }
+
+            system->UnregisterEventHandler(hotPlugEventHandler);
+        }
+
+        // Release any resources.
+        for (auto &pipeline : pipelines) {
+            pipeline->stop();
+        }
+        pipelines.clear();
+        if (frameSetArea) {
+            std::clog << "[opendlv-device-camera-spinnaker]: " << frameSetArea->incompleteSets() << " incomplete frame sets discarded." << std::endl;
         }
-        retCode = 0;
+        listOfInterfaces.Clear();
+        system->ReleaseInstance();
     }
     return retCode;
 }
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "remap-table.hpp"
+#include "conversion-kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+constexpr uint32_t RemapTable::TILE_WIDTH;
+constexpr uint32_t RemapTable::TILE_HEIGHT;
+
+bool RemapTable::Calibration::valid() const noexcept {
+    return (0.0 < fx) && (0.0 < fy);
+}
+
+bool RemapTable::readCalibration(const std::string &file, Calibration &calibration) noexcept {
+    std::ifstream in(file);
+    if (!in.good()) {
+        return false;
+    }
+    Calibration retVal;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || ('#' == key[0])) {
+            continue;
+        }
+        std::vector<double> values;
+        double value{0.0};
+        while (fields >> value) {
+            values.push_back(value);
+        }
+        if (!fields.eof()) {
+            return false;
+        }
+        if (("size" == key) && (2 == values.size()) && (0.0 < values[0]) && (0.0 < values[1])) {
+            retVal.width  = static_cast<uint32_t>(values[0]);
+            retVal.height = static_cast<uint32_t>(values[1]);
+        } else if (("K" == key) && (4 == values.size())) {
+            retVal.fx = values[0];
+            retVal.fy = values[1];
+            retVal.cx = values[2];
+            retVal.cy = values[3];
+        } else if (("D" == key) && ((4 == values.size()) || (5 == values.size()))) {
+            retVal.k1 = values[0];
+            retVal.k2 = values[1];
+            retVal.p1 = values[2];
+            retVal.p2 = values[3];
+            retVal.k3 = (5 == values.size()) ? values[4] : 0.0;
+        } else if (("R" == key) && (9 == values.size())) {
+            std::copy(values.begin(), values.end(), retVal.rotation);
+        } else if (("P" == key) && (4 == values.size())) {
+            retVal.outputFx = values[0];
+            retVal.outputFy = values[1];
+            retVal.outputCx = values[2];
+            retVal.outputCy = values[3];
+        } else {
+            return false;
+        }
+    }
+    calibration = retVal;
+    return retVal.valid();
+}
+
+RemapTable::RemapTable(const Calibration &calibration, uint32_t width, uint32_t height, uint32_t subsampling) noexcept
+    : m_width{width / subsampling}
+    , m_height{height / subsampling}
+    , m_offsets(m_width * m_height, kernels::REMAP_OUTSIDE)
+    , m_fractions(m_width * m_height, 0) {
+    if (!calibration.valid() || (2 > m_width) || (2 > m_height)) {
+        return;
+    }
+    // Intrinsics of another resolution are scaled about the pixel centres.
+    const double SX{(0 < calibration.width) ? static_cast<double>(width) / calibration.width : 1.0};
+    const double SY{(0 < calibration.height) ? static_cast<double>(height) / calibration.height : 1.0};
+    const double FX{calibration.fx * SX};
+    const double FY{calibration.fy * SY};
+    const double CX{(calibration.cx + 0.5) * SX - 0.5};
+    const double CY{(calibration.cy + 0.5) * SY - 0.5};
+    const bool WITH_OUTPUT{0.0 < calibration.outputFx};
+    const double OUTPUT_FX{WITH_OUTPUT ? calibration.outputFx * SX : FX};
+    const double OUTPUT_FY{WITH_OUTPUT ? calibration.outputFy * SY : FY};
+    const double OUTPUT_CX{WITH_OUTPUT ? (calibration.outputCx + 0.5) * SX - 0.5 : CX};
+    const double OUTPUT_CY{WITH_OUTPUT ? (calibration.outputCy + 0.5) * SY - 0.5 : CY};
+    const double *R{calibration.rotation};
+    const double S{static_cast<double>(subsampling)};
+    const int64_t ONE{1 << kernels::REMAP_FRACTION_BITS};
+
+    // Entries are stored in the order in which remap() reads them.
+    uint32_t i{0};
+    for (uint32_t top{0}; top < m_height; top += TILE_HEIGHT) {
+        const uint32_t ROWS{std::min(TILE_HEIGHT, m_height - top)};
+        for (uint32_t left{0}; left < m_width; left += TILE_WIDTH) {
+            const uint32_t COLUMNS{std::min(TILE_WIDTH, m_width - left)};
+            for (uint32_t y{top}; y < top + ROWS; y++) {
+                for (uint32_t x{left}; x < left + COLUMNS; x++, i++) {
+                    // Ray of the output pixel's centre, rotated back into the camera; R is orthonormal.
+                    const double U{((x + 0.5) * S - 0.5 - OUTPUT_CX) / OUTPUT_FX};
+                    const double V{((y + 0.5) * S - 0.5 - OUTPUT_CY) / OUTPUT_FY};
+                    const double RX{R[0] * U + R[3] * V + R[6]};
+                    const double RY{R[1] * U + R[4] * V + R[7]};
+                    const double RZ{R[2] * U + R[5] * V + R[8]};
+                    if (0.0 >= RZ) {
+                        continue;
+                    }
+                    const double XN{RX / RZ};
+                    const double YN{RY / RZ};
+                    const double R2{XN * XN + YN * YN};
+                    const double RADIAL{1.0 + R2 * (calibration.k1 + R2 * (calibration.k2 + R2 * calibration.k3))};
+                    const double XD{XN * RADIAL + 2.0 * calibration.p1 * XN * YN + calibration.p2 * (R2 + 2.0 * XN * XN)};
+                    const double YD{YN * RADIAL + calibration.p1 * (R2 + 2.0 * YN * YN) + 2.0 * calibration.p2 * XN * YN};
+                    // Position in the distorted plane, which may be subsampled.
+                    const double SRC_X{(FX * XD + CX + 0.5) / S - 0.5};
+                    const double SRC_Y{(FY * YD + CY + 0.5) / S - 0.5};
+                    if ((-0.5 > SRC_X) || (-0.5 > SRC_Y) || (m_width - 0.5 < SRC_X) || (m_height - 0.5 < SRC_Y)) {
+                        continue;
+                    }
+                    const int64_t FIXED_X{std::llround(std::min(std::max(SRC_X, 0.0), m_width - 1.0) * ONE)};
+                    const int64_t FIXED_Y{std::llround(std::min(std::max(SRC_Y, 0.0), m_height - 1.0) * ONE)};
+                    // The last column and row are reached from the ones before them.
+                    const int64_t X0{std::min<int64_t>(FIXED_X / ONE, m_width - 2)};
+                    const int64_t Y0{std::min<int64_t>(FIXED_Y / ONE, m_height - 2)};
+                    m_offsets[i]   = static_cast<uint32_t>(Y0 * m_width + X0);
+                    m_fractions[i] = static_cast<uint16_t>((FIXED_X - X0 * ONE) | ((FIXED_Y - Y0 * ONE) << 8));
+                }
+            }
+        }
+    }
+}
+
+uint32_t RemapTable::tileRows() const noexcept {
+    return (m_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+}
+
+void RemapTable::remap(const uint8_t *src, uint8_t *dst, uint32_t bytesPerPixel, uint32_t border, uint32_t firstTileRow, uint32_t lastTileRow) const noexcept {
+    for (uint32_t tileRow{firstTileRow}; tileRow < lastTileRow; tileRow++) {
+        const uint32_t TOP{tileRow * TILE_HEIGHT};
+        const uint32_t ROWS{std::min(TILE_HEIGHT, m_height - TOP)};
+        uint32_t i{TOP * m_width};
+        for (uint32_t left{0}; left < m_width; left += TILE_WIDTH) {
+            const uint32_t COLUMNS{std::min(TILE_WIDTH, m_width - left)};
+            for (uint32_t y{TOP}; y < TOP + ROWS; y++) {
+                kernels::remap(src, m_width, dst + (y * m_width + left) * bytesPerPixel, m_offsets.data() + i, m_fractions.data() + i, COLUMNS, bytesPerPixel, border);
+                i += COLUMNS;
+            }
+        }
+    }
+}
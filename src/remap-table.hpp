@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REMAP_TABLE_HPP
+#define REMAP_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Source positions of the pixels of an undistorted and, optionally,
+ * rectified frame, computed once from a camera calibration. The positions
+ * are stored in fixed point (cf. kernels::remap) and in the order of tiles
+ * of TILE_WIDTH x TILE_HEIGHT output pixels, so that the source pixels of a
+ * tile stay in the cache while it is interpolated.
+ */
+class RemapTable {
+   public:
+    static constexpr uint32_t TILE_WIDTH{64};
+    static constexpr uint32_t TILE_HEIGHT{16};
+
+    // Pinhole camera with radial and tangential distortion as calibrated by OpenCV.
+    struct Calibration {
+        // Size of the calibrated frames; the intrinsics are scaled to frames of another size.
+        uint32_t width{0};
+        uint32_t height{0};
+        // Focal lengths and principal point of the camera matrix.
+        double fx{0.0};
+        double fy{0.0};
+        double cx{0.0};
+        double cy{0.0};
+        // Distortion coefficients.
+        double k1{0.0};
+        double k2{0.0};
+        double p1{0.0};
+        double p2{0.0};
+        double k3{0.0};
+        // Rotation from the camera into the rectified camera, row by row.
+        double rotation[9]{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+        // Focal lengths and principal point of the output; the camera's if 0.
+        double outputFx{0.0};
+        double outputFy{0.0};
+        double outputCx{0.0};
+        double outputCy{0.0};
+
+        /**
+         * @return true if the calibration has focal lengths.
+         */
+        bool valid() const noexcept;
+    };
+
+    /**
+     * This method reads a calibration from a file with one entry per line:
+     * "size W H", "K fx fy cx cy", "D k1 k2 p1 p2 [k3]", and, optionally,
+     * "R r11 r12 ... r33" and "P fx fy cx cy". Lines starting with '#' are
+     * ignored.
+     *
+     * @param file File to read.
+     * @param calibration Calibration read.
+     * @return true if the file holds a valid calibration.
+     */
+    static bool readCalibration(const std::string &file, Calibration &calibration) noexcept;
+
+   private:
+    RemapTable(const RemapTable &) = delete;
+    RemapTable(RemapTable &&)      = delete;
+    RemapTable &operator=(const RemapTable &) = delete;
+    RemapTable &operator=(RemapTable &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param calibration Calibration of the camera.
+     * @param width Width of a frame.
+     * @param height Height of a frame.
+     * @param subsampling 1 for the Y plane and ARGB frames, 2 for the chroma planes of I420.
+     */
+    RemapTable(const Calibration &calibration, uint32_t width, uint32_t height, uint32_t subsampling) noexcept;
+    ~RemapTable() = default;
+
+   public:
+    /**
+     * @return Number of rows of tiles.
+     */
+    uint32_t tileRows() const noexcept;
+
+    /**
+     * This method interpolates the given rows of tiles of a plane or an ARGB frame.
+     *
+     * @param src Distorted plane or frame.
+     * @param dst Undistorted plane or frame of the same size.
+     * @param bytesPerPixel 1 for a plane, 4 for ARGB.
+     * @param border Value of pixels outside the distorted frame, byte 0 first.
+     * @param firstTileRow First row of tiles to interpolate.
+     * @param lastTileRow Row of tiles after the last one to interpolate.
+     */
+    void remap(const uint8_t *src, uint8_t *dst, uint32_t bytesPerPixel, uint32_t border, uint32_t firstTileRow, uint32_t lastTileRow) const noexcept;
+
+   private:
+    const uint32_t m_width;
+    const uint32_t m_height;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint16_t> m_fractions;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared-memory-area.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+SharedMemoryArea::Mode SharedMemoryArea::modeFromString(const std::string &mode) noexcept {
+    if ("ring" == mode) {
+        return Mode::RING;
+    }
+    return ("seqlock" == mode) ? Mode::SEQLOCK : Mode::LOCK;
+}
+
+SharedMemoryArea::SharedMemoryArea(const std::string &name, uint32_t frameSize, uint32_t width, uint32_t height, uint32_t fourcc, Mode mode, uint32_t slots) noexcept
+    : m_mode{mode} {
+    // Lock and seqlock areas hold one slot that starts at offset 0.
+    const bool SINGLE{Mode::RING != m_mode};
+    const uint32_t COUNT{SINGLE ? 1 : std::min(std::max(slots, 2u), layout::MAX_SLOTS)};
+    const uint64_t PADDING{SINGLE ? 0 : layout::CACHE_LINE};
+    const uint64_t STRIDE{layout::alignUp(frameSize, layout::CACHE_LINE)};
+    const uint64_t SIZE{layout::alignUp(PADDING + COUNT * STRIDE, layout::CACHE_LINE) + sizeof(layout::Trailer)};
+    m_sharedMemory.reset(new cluon::SharedMemory{name, static_cast<uint32_t>(SIZE)});
+    if (m_sharedMemory && m_sharedMemory->valid()) {
+        char *data{m_sharedMemory->data()};
+        m_trailer = layout::trailerOf(data, m_sharedMemory->size());
+        std::memset(static_cast<void *>(m_trailer), 0, sizeof(layout::Trailer));
+        m_trailer->magic           = layout::MAGIC;
+        m_trailer->version         = layout::VERSION;
+        m_trailer->fourcc          = fourcc;
+        m_trailer->width           = width;
+        m_trailer->height          = height;
+        m_trailer->slotCount       = COUNT;
+        m_trailer->slotSize        = frameSize;
+        m_trailer->slotStride      = static_cast<uint32_t>(STRIDE);
+        m_trailer->firstSlotOffset = SINGLE ? 0 : static_cast<uint32_t>(layout::alignUp(reinterpret_cast<uint64_t>(data), layout::CACHE_LINE) - reinterpret_cast<uint64_t>(data));
+        m_trailer->frameCount      = 1;
+        m_trailer->frameStride     = static_cast<uint32_t>(STRIDE);
+        m_trailer->latest.store(COUNT - 1);
+    }
+}
+
+bool SharedMemoryArea::valid() noexcept {
+    return (m_sharedMemory && m_sharedMemory->valid() && (nullptr != m_trailer));
+}
+
+std::string SharedMemoryArea::name() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->name() : "");
+}
+
+uint32_t SharedMemoryArea::size() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->size() : 0);
+}
+
+uint8_t *SharedMemoryArea::beginWrite(const cluon::data::TimeStamp &ts) noexcept {
+    if (Mode::LOCK == m_mode) {
+        m_sharedMemory->lock();
+        m_sharedMemory->setTimeStamp(ts);
+        m_slot      = 0;
+        m_timestamp = cluon::time::toMicroseconds(ts);
+        return slot(m_slot);
+    }
+
+    // In a ring, the latest completed slot is never overwritten; a seqlock
+    // area invalidates its only slot first.
+    m_slot      = (m_trailer->latest.load(std::memory_order_relaxed) + 1) % m_trailer->slotCount;
+    m_timestamp = cluon::time::toMicroseconds(ts);
+    m_trailer->slots[m_slot].sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot(m_slot);
+}
+
+void SharedMemoryArea::endWrite(const layout::FrameMetadata &metadata) noexcept {
+    m_trailer->slots[m_slot].timestamp = m_timestamp;
+    m_trailer->slots[m_slot].metadata  = metadata;
+    m_trailer->slots[m_slot].sequence.store(++m_sequence, std::memory_order_release);
+    m_trailer->latest.store(m_slot, std::memory_order_release);
+    if (Mode::LOCK == m_mode) {
+        m_sharedMemory->unlock();
+    }
+}
+
+bool SharedMemoryArea::hasActiveReaders(int64_t timeout) const noexcept {
+    return layout::hasActiveReaders(m_trailer, cluon::time::toMicroseconds(cluon::time::now()), timeout);
+}
+
+void SharedMemoryArea::notifyAll() noexcept {
+    m_sharedMemory->notifyAll();
+}
+
+uint8_t *SharedMemoryArea::slot(uint32_t index) noexcept {
+    return reinterpret_cast<uint8_t *>(m_sharedMemory->data() + m_trailer->firstSlotOffset + index * m_trailer->slotStride);
+}
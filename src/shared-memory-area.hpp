@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARED_MEMORY_AREA_HPP
+#define SHARED_MEMORY_AREA_HPP
+
+#include "cluon-complete.hpp"
+#include "shared-memory-layout.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Output area for converted frames; every area ends with a trailer as
+ * described in shared-memory-layout.hpp that carries the frames' metadata.
+ * In LOCK mode, the area holds exactly one frame at offset 0 that is
+ * protected by the shared memory's mutex. In RING
+ * mode, the area holds several slots (cf. shared-memory-layout.hpp); the
+ * producer always writes the slot after the latest completed one and never
+ * takes the mutex, so readers that pick the latest slot never stall it.
+ * SEQLOCK mode keeps the single frame at offset 0 but replaces the mutex by
+ * the sequence number of the only slot: readers copy or process the frame
+ * and retry if the sequence number changed underneath them.
+ */
+class SharedMemoryArea {
+   public:
+    enum class Mode { LOCK, RING, SEQLOCK };
+
+    /**
+     * @param mode Name of the publication mode ("lock", "ring", or "seqlock").
+     * @return Parsed mode; LOCK for unknown names.
+     */
+    static Mode modeFromString(const std::string &mode) noexcept;
+
+   private:
+    SharedMemoryArea(const SharedMemoryArea &) = delete;
+    SharedMemoryArea(SharedMemoryArea &&)      = delete;
+    SharedMemoryArea &operator=(const SharedMemoryArea &) = delete;
+    SharedMemoryArea &operator=(SharedMemoryArea &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param name Name of the shared memory area.
+     * @param frameSize Size of one frame.
+     * @param width Width of a frame.
+     * @param height Height of a frame.
+     * @param fourcc Pixel format of a frame.
+     * @param mode Publication mode.
+     * @param slots Number of slots in RING mode (2 to layout::MAX_SLOTS).
+     */
+    SharedMemoryArea(const std::string &name, uint32_t frameSize, uint32_t width, uint32_t height, uint32_t fourcc, Mode mode, uint32_t slots) noexcept;
+    ~SharedMemoryArea() = default;
+
+   public:
+    bool valid() noexcept;
+    std::string name() const noexcept;
+    uint32_t size() const noexcept;
+
+    /**
+     * This method starts writing the next frame.
+     *
+     * @param ts Sample time stamp of the frame.
+     * @return Pointer to write the frame to.
+     */
+    uint8_t *beginWrite(const cluon::data::TimeStamp &ts) noexcept;
+
+    /**
+     * This method completes writing the frame started with beginWrite().
+     *
+     * @param metadata Metadata of the frame.
+     */
+    void endWrite(const layout::FrameMetadata &metadata) noexcept;
+
+    /**
+     * @param timeout Maximum age in microseconds of the readers' heartbeat.
+     * @return true if a reader of this area read or waited for a frame within the timeout.
+     */
+    bool hasActiveReaders(int64_t timeout) const noexcept;
+
+    /**
+     * This method wakes up all processes waiting for a new frame.
+     */
+    void notifyAll() noexcept;
+
+   private:
+    uint8_t *slot(uint32_t index) noexcept;
+
+   private:
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory{nullptr};
+    const Mode m_mode;
+    layout::Trailer *m_trailer{nullptr};
+    uint32_t m_slot{0};
+    uint64_t m_sequence{0};
+    int64_t m_timestamp{0};
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARED_MEMORY_LAYOUT_HPP
+#define SHARED_MEMORY_LAYOUT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Layout of the control block ("trailer") that is placed at the very end of
+ * a shared memory area holding one or more image slots:
+ *
+ *   [padding][slot 0][slot 1]...[slot n-1][padding][Trailer]
+ *
+ * Slot i starts at firstSlotOffset + i * slotStride bytes from the beginning
+ * of the shared memory's data. A consumer finds the trailer at
+ * data() + size() - sizeof(Trailer) without knowing the image dimensions.
+ * Each slot's header carries the FrameMetadata of the frame in the slot.
+ *
+ * A slot usually holds one frame. A frame set area holds frameCount frames
+ * per slot (one per camera, frameStride bytes apart), followed by one
+ * FrameMetadata record per frame at offset frameCount * frameStride.
+ *
+ * The area's size is a multiple of CACHE_LINE, so the trailer shares the
+ * (at least 8 byte) alignment of data().
+ *
+ * A writer sets the slot's `sequence` to 0, issues a release fence, writes
+ * the frame, stores the new (non-zero) `sequence` with release semantics and
+ * finally updates `latest`. Readers load `latest`, load the slot's `sequence`
+ * with acquire semantics, process the slot, issue an acquire fence, and
+ * accept the result only if `sequence` is unchanged and not zero afterwards.
+ *
+ * Readers register in the trailer: they call attachReader() once, touchReader()
+ * whenever they read a frame (and at least once per timeout while waiting for
+ * one), and detachReader() when they are done. A producer may stop writing
+ * an area whose heartbeat is older than its timeout and resumes with the next
+ * frame after a reader touched it again; the number of attached readers is
+ * informative only, as a crashed reader never detaches.
+ */
+namespace layout {
+
+// "ODLV" in little endian.
+constexpr uint32_t MAGIC{0x564c444f};
+constexpr uint32_t VERSION{4};
+constexpr uint32_t MAX_SLOTS{16};
+constexpr uint32_t CACHE_LINE{64};
+
+static_assert(2 == ATOMIC_LLONG_LOCK_FREE, "64-bit atomics must be lock-free to be shared between processes.");
+static_assert(2 == ATOMIC_INT_LOCK_FREE, "32-bit atomics must be lock-free to be shared between processes.");
+
+// Bits in FrameMetadata::flags telling which fields are filled.
+constexpr uint32_t METADATA_FRAME_ID{1u << 0};
+constexpr uint32_t METADATA_CAMERA_TIMESTAMP{1u << 1};
+constexpr uint32_t METADATA_HOST_RECEIVE_TIME{1u << 2};
+constexpr uint32_t METADATA_CONVERSION_DONE_TIME{1u << 3};
+constexpr uint32_t METADATA_EXPOSURE_TIME{1u << 4};
+constexpr uint32_t METADATA_GAIN{1u << 5};
+constexpr uint32_t METADATA_BALANCE_RATIOS{1u << 6};
+
+constexpr uint32_t METADATA_VERSION{1};
+
+/**
+ * Per-frame camera state and latency stamps.
+ */
+struct FrameMetadata {
+    uint32_t version;
+    uint32_t flags;
+    // Frame counter of the camera.
+    uint64_t frameId;
+    // Camera time stamp in nanoseconds.
+    uint64_t cameraTimestamp;
+    // Host time in microseconds when the frame was received from the camera.
+    int64_t hostReceiveTime;
+    // Host time in microseconds when the frame in this area was converted.
+    int64_t conversionDoneTime;
+    // Exposure time in microseconds.
+    double exposureTime;
+    // Gain in dB.
+    double gain;
+    // White balance ratios relative to green.
+    double balanceRatioRed;
+    double balanceRatioBlue;
+};
+
+struct alignas(CACHE_LINE) SlotHeader {
+    // Frame counter of the frame in this slot; 0 while the slot is invalid.
+    std::atomic<uint64_t> sequence;
+    // Sample time stamp in microseconds.
+    int64_t timestamp;
+    alignas(CACHE_LINE) FrameMetadata metadata;
+};
+
+struct alignas(CACHE_LINE) Trailer {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fourcc;
+    uint32_t width;
+    uint32_t height;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint32_t slotStride;
+    uint32_t firstSlotOffset;
+    uint32_t frameCount;
+    uint32_t frameStride;
+    // Index of the most recently completed slot.
+    alignas(CACHE_LINE) std::atomic<uint32_t> latest;
+    // Number of attached readers.
+    alignas(CACHE_LINE) std::atomic<uint32_t> readers;
+    // Host time in microseconds when a reader last read or waited for a frame.
+    std::atomic<int64_t> heartbeat;
+    SlotHeader slots[MAX_SLOTS];
+};
+
+/**
+ * @return value rounded up to the next multiple of alignment.
+ */
+constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) noexcept {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @return FourCC code for the given four characters.
+ */
+constexpr uint32_t fourcc(char a, char b, char c, char d) noexcept {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) | (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+/**
+ * @return Pointer to the trailer of a shared memory area.
+ */
+inline Trailer *trailerOf(char *data, uint32_t size) noexcept {
+    return reinterpret_cast<Trailer *>(data + size - sizeof(Trailer));
+}
+
+/**
+ * This function registers a reader of an area.
+ *
+ * @param trailer Trailer of the area.
+ * @param now Host time in microseconds.
+ */
+inline void attachReader(Trailer *trailer, int64_t now) noexcept {
+    trailer->heartbeat.store(now, std::memory_order_relaxed);
+    trailer->readers.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * This function tells the producer that a reader is still interested.
+ *
+ * @param trailer Trailer of the area.
+ * @param now Host time in microseconds.
+ */
+inline void touchReader(Trailer *trailer, int64_t now) noexcept {
+    trailer->heartbeat.store(now, std::memory_order_relaxed);
+}
+
+/**
+ * This function unregisters a reader of an area.
+ *
+ * @param trailer Trailer of the area.
+ */
+inline void detachReader(Trailer *trailer) noexcept {
+    uint32_t readers{trailer->readers.load(std::memory_order_relaxed)};
+    while ((0 < readers) && !trailer->readers.compare_exchange_weak(readers, readers - 1, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @param trailer Trailer of the area.
+ * @param now Host time in microseconds.
+ * @param timeout Maximum age in microseconds of the readers' heartbeat.
+ * @return true if a reader read or waited for a frame within the timeout.
+ */
+inline bool hasActiveReaders(const Trailer *trailer, int64_t now, int64_t timeout) noexcept {
+    return (now - trailer->heartbeat.load(std::memory_order_relaxed) <= timeout);
+}
+
+} // namespace layout
+
+#endif
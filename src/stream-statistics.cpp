@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "stream-statistics.hpp"
+
+#include <sstream>
+
+uint64_t StreamStatistics::Report::lost() const noexcept {
+    return incompleteFrames + frameIdGaps + queueDrops;
+}
+
+std::string StreamStatistics::Report::toString() const noexcept {
+    std::stringstream sstr;
+    sstr << "fps=" << ((0 < period) ? static_cast<double>(frames) / period : 0.0)
+         << " frames=" << frames
+         << " incomplete=" << incompleteFrames
+         << " frameIdGaps=" << frameIdGaps
+         << " queueDrops=" << queueDrops
+         << " failedBuffers=" << failedBuffers
+         << " bufferUnderruns=" << bufferUnderruns
+         << " lostFrames=" << lostFrames
+         << " lostPackets=" << lostPackets
+         << " resendRequests=" << resendRequests;
+    return sstr.str();
+}
+
+bool StreamStatistics::countFrame(const Spinnaker::ImagePtr &image) noexcept {
+    m_frames++;
+    try {
+        const uint64_t FRAME_ID{image->GetFrameID()};
+        if (m_hasLastFrameId && (FRAME_ID > m_lastFrameId + 1)) {
+            m_frameIdGaps += FRAME_ID - m_lastFrameId - 1;
+        }
+        m_lastFrameId    = FRAME_ID;
+        m_hasLastFrameId = true;
+
+        if ((Spinnaker::IMAGE_NO_ERROR == image->GetImageStatus()) && !image->IsIncomplete() && (image->GetTimeStamp() > 0)) {
+            return true;
+        }
+    }
+    catch (...) {
+        // Treat an unreadable image as incomplete.
+    }
+    m_incompleteFrames++;
+    return false;
+}
+
+StreamStatistics::Report StreamStatistics::sample(Spinnaker::GenApi::INodeMap *streamNodeMap, uint64_t queueDrops) noexcept {
+    const int64_t NOW{cluon::time::toMicroseconds(cluon::time::now())};
+
+    Report report;
+    report.period           = (0 < m_lastSample) ? static_cast<double>(NOW - m_lastSample) / 1000000.0 : 0.0;
+    report.frames           = m_frames.exchange(0);
+    report.incompleteFrames = m_incompleteFrames.exchange(0);
+    report.frameIdGaps      = m_frameIdGaps.exchange(0);
+    report.queueDrops       = queueDrops - m_queueDrops;
+    report.failedBuffers    = delta(streamNodeMap, "StreamFailedBufferCount");
+    report.bufferUnderruns  = delta(streamNodeMap, "StreamBufferUnderrunCount");
+    report.lostFrames       = delta(streamNodeMap, "StreamLostFrameCount");
+    report.lostPackets      = delta(streamNodeMap, "StreamLostPacketCount");
+    report.resendRequests   = delta(streamNodeMap, "StreamPacketResendRequestCount");
+
+    m_queueDrops = queueDrops;
+    m_lastSample = NOW;
+    return report;
+}
+
+uint64_t StreamStatistics::delta(Spinnaker::GenApi::INodeMap *streamNodeMap, const std::string &node) noexcept {
+    uint64_t retVal{0};
+    if (nullptr == streamNodeMap) {
+        // A reconnected camera starts its counters from 0 again.
+        m_streamCounters.erase(node);
+        return retVal;
+    }
+    try {
+        Spinnaker::GenApi::CIntegerPtr counter = streamNodeMap->GetNode(node.c_str());
+        if (IsAvailable(counter) && IsReadable(counter)) {
+            const uint64_t VALUE{static_cast<uint64_t>(counter->GetValue())};
+            if (0 != m_streamCounters.count(node)) {
+                retVal = (VALUE >= m_streamCounters[node]) ? VALUE - m_streamCounters[node] : VALUE;
+            }
+            m_streamCounters[node] = VALUE;
+        }
+    }
+    catch (...) {
+        // Counter not supported by this transport layer.
+    }
+    return retVal;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STREAM_STATISTICS_HPP
+#define STREAM_STATISTICS_HPP
+
+#include <Spinnaker.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Counts incomplete frames and gaps in the camera's frame IDs as frames
+ * arrive, and combines them with the transport layer's stream counters
+ * into periodic reports.
+ */
+class StreamStatistics {
+   public:
+    struct Report {
+        double period{0};
+        uint64_t frames{0};
+        uint64_t incompleteFrames{0};
+        uint64_t frameIdGaps{0};
+        uint64_t queueDrops{0};
+        // Deltas of the transport layer's stream counters.
+        uint64_t failedBuffers{0};
+        uint64_t bufferUnderruns{0};
+        uint64_t lostFrames{0};
+        uint64_t lostPackets{0};
+        uint64_t resendRequests{0};
+
+        /**
+         * @return Number of frames that did not make it to the conversion.
+         */
+        uint64_t lost() const noexcept;
+        std::string toString() const noexcept;
+    };
+
+   private:
+    StreamStatistics(const StreamStatistics &) = delete;
+    StreamStatistics(StreamStatistics &&)      = delete;
+    StreamStatistics &operator=(const StreamStatistics &) = delete;
+    StreamStatistics &operator=(StreamStatistics &&) = delete;
+
+   public:
+    StreamStatistics() = default;
+    ~StreamStatistics() = default;
+
+   public:
+    /**
+     * This method counts a frame as delivered by the camera; it must be
+     * called from one thread only.
+     *
+     * @param image Image delivered by the camera.
+     * @return true if the frame is complete.
+     */
+    bool countFrame(const Spinnaker::ImagePtr &image) noexcept;
+
+    /**
+     * This method summarizes the period since the previous call.
+     *
+     * @param streamNodeMap The camera's TLStream node map; nullptr while there is no camera.
+     * @param queueDrops Total number of frames dropped by the frame queue.
+     * @return Report for the period.
+     */
+    Report sample(Spinnaker::GenApi::INodeMap *streamNodeMap, uint64_t queueDrops) noexcept;
+
+   private:
+    uint64_t delta(Spinnaker::GenApi::INodeMap *streamNodeMap, const std::string &node) noexcept;
+
+   private:
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_incompleteFrames{0};
+    std::atomic<uint64_t> m_frameIdGaps{0};
+    uint64_t m_lastFrameId{0};
+    bool m_hasLastFrameId{false};
+
+    uint64_t m_queueDrops{0};
+    std::map<std::string, uint64_t> m_streamCounters{};
+    int64_t m_lastSample{0};
+};
+
+#endif
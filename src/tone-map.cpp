@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tone-map.hpp"
+
+#include <cmath>
+#include <fstream>
+
+namespace {
+// Compression of the logarithmic curve (as in mu-law).
+constexpr double LOG_MU{255.0};
+} // namespace
+
+constexpr uint32_t ToneMap::SIZE;
+
+ToneMap::Curve ToneMap::curveFromString(const std::string &curve) noexcept {
+    return ("log" == curve) ? Curve::LOG : Curve::LINEAR;
+}
+
+ToneMap::ToneMap(Curve curve) noexcept {
+    m_table.resize(SIZE);
+    for (uint32_t i{0}; i < SIZE; i++) {
+        if (Curve::LOG == curve) {
+            const double X{static_cast<double>(i) / (SIZE - 1)};
+            m_table[i] = static_cast<uint8_t>(std::lround(255.0 * std::log1p(LOG_MU * X) / std::log1p(LOG_MU)));
+        } else {
+            m_table[i] = static_cast<uint8_t>(i >> 4);
+        }
+    }
+}
+
+ToneMap::ToneMap(const std::string &file) noexcept {
+    std::ifstream in(file);
+    int32_t value{0};
+    while ((m_table.size() < SIZE) && (in >> value)) {
+        if ((value < 0) || (value > 255)) {
+            break;
+        }
+        m_table.push_back(static_cast<uint8_t>(value));
+    }
+}
+
+bool ToneMap::valid() const noexcept {
+    return (SIZE == m_table.size());
+}
+
+const std::vector<uint8_t> &ToneMap::table() const noexcept {
+    return m_table;
+}
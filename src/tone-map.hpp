@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TONE_MAP_HPP
+#define TONE_MAP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Lookup table that maps high bit depth samples to 8 bits. The table is
+ * indexed by the upper 12 bits of a sample that is left-aligned in 16 bits,
+ * so that 12-bit and 16-bit formats share one table.
+ */
+class ToneMap {
+   public:
+    // LINEAR keeps the upper 8 bits; LOG lifts the shadows logarithmically.
+    enum class Curve { LINEAR, LOG };
+
+    static constexpr uint32_t SIZE{4096};
+
+    /**
+     * @param curve Name of the curve ("linear" or "log").
+     * @return Parsed curve; LINEAR for unknown names.
+     */
+    static Curve curveFromString(const std::string &curve) noexcept;
+
+   private:
+    ToneMap(const ToneMap &) = delete;
+    ToneMap(ToneMap &&)      = delete;
+    ToneMap &operator=(const ToneMap &) = delete;
+    ToneMap &operator=(ToneMap &&) = delete;
+
+   public:
+    /**
+     * Constructor for a predefined curve.
+     *
+     * @param curve Curve to tabulate.
+     */
+    explicit ToneMap(Curve curve) noexcept;
+
+    /**
+     * Constructor for a table given in a file.
+     *
+     * @param file File with 4096 whitespace-separated values from 0 to 255.
+     */
+    explicit ToneMap(const std::string &file) noexcept;
+    ~ToneMap() = default;
+
+   public:
+    bool valid() const noexcept;
+    const std::vector<uint8_t> &table() const noexcept;
+
+   private:
+    std::vector<uint8_t> m_table{};
+};
+
+#endif
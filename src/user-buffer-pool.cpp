@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user-buffer-pool.hpp"
+
+#include <cstring>
+
+namespace {
+// Stream buffers are page aligned.
+constexpr uint64_t BUFFER_ALIGNMENT{4096};
+} // namespace
+
+UserBufferPool::UserBufferPool(const std::string &name, uint32_t bufferCount, uint32_t bufferSize, uint32_t width, uint32_t height, uint32_t fourcc) noexcept
+    : m_bufferSize{bufferSize} {
+    const uint32_t COUNT{(bufferCount < layout::MAX_SLOTS) ? bufferCount : layout::MAX_SLOTS};
+    const uint64_t STRIDE{layout::alignUp(bufferSize, BUFFER_ALIGNMENT)};
+    const uint64_t SIZE{layout::alignUp(BUFFER_ALIGNMENT + COUNT * STRIDE, layout::CACHE_LINE) + sizeof(layout::Trailer)};
+    m_sharedMemory.reset(new cluon::SharedMemory{name, static_cast<uint32_t>(SIZE)});
+    if (m_sharedMemory && m_sharedMemory->valid()) {
+        char *data{m_sharedMemory->data()};
+        const uint64_t FIRST_SLOT_OFFSET{layout::alignUp(reinterpret_cast<uint64_t>(data), BUFFER_ALIGNMENT) - reinterpret_cast<uint64_t>(data)};
+        for (uint32_t i{0}; i < COUNT; i++) {
+            m_buffers.push_back(data + FIRST_SLOT_OFFSET + i * STRIDE);
+        }
+
+        m_trailer = layout::trailerOf(data, m_sharedMemory->size());
+        std::memset(static_cast<void *>(m_trailer), 0, sizeof(layout::Trailer));
+        m_trailer->magic           = layout::MAGIC;
+        m_trailer->version         = layout::VERSION;
+        m_trailer->fourcc          = fourcc;
+        m_trailer->width           = width;
+        m_trailer->height          = height;
+        m_trailer->slotCount       = COUNT;
+        m_trailer->slotSize        = bufferSize;
+        m_trailer->slotStride      = static_cast<uint32_t>(STRIDE);
+        m_trailer->firstSlotOffset = static_cast<uint32_t>(FIRST_SLOT_OFFSET);
+        m_trailer->frameCount      = 1;
+        m_trailer->frameStride     = static_cast<uint32_t>(STRIDE);
+    }
+}
+
+UserBufferPool::~UserBufferPool() {
+    release();
+}
+
+bool UserBufferPool::valid() noexcept {
+    return (m_sharedMemory && m_sharedMemory->valid() && (nullptr != m_trailer));
+}
+
+std::string UserBufferPool::name() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->name() : "");
+}
+
+uint32_t UserBufferPool::size() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->size() : 0);
+}
+
+void UserBufferPool::attach(Spinnaker::CameraPtr camera) {
+    camera->SetUserBuffers(m_buffers.data(), m_buffers.size(), m_bufferSize);
+}
+
+bool UserBufferPool::publish(Frame &frame, const cluon::data::TimeStamp &ts) noexcept {
+    const int32_t slot{slotOf(frame)};
+    if (0 > slot) {
+        return false;
+    }
+
+    m_trailer->slots[slot].timestamp = cluon::time::toMicroseconds(ts);
+    m_trailer->slots[slot].metadata  = frame.metadata;
+    m_trailer->slots[slot].sequence.store(++m_sequence, std::memory_order_release);
+    m_trailer->latest.store(static_cast<uint32_t>(slot), std::memory_order_release);
+
+    // Invalidate the previous slot before the camera may overwrite it.
+    release();
+    m_published     = std::move(frame);
+    m_publishedSlot = slot;
+    frame           = Frame{};
+
+    m_sharedMemory->notifyAll();
+    return true;
+}
+
+void UserBufferPool::release() noexcept {
+    if (0 <= m_publishedSlot) {
+        m_trailer->slots[m_publishedSlot].sequence.store(0, std::memory_order_release);
+        m_publishedSlot = -1;
+    }
+    releaseFrame(m_published);
+}
+
+int32_t UserBufferPool::slotOf(const Frame &frame) noexcept {
+    if (frame.image.IsValid()) {
+        const char *ptr{static_cast<const char *>(frame.image->GetData())};
+        for (uint32_t i{0}; i < m_buffers.size(); i++) {
+            const char *buffer{static_cast<const char *>(m_buffers[i])};
+            if ((buffer <= ptr) && (ptr < buffer + m_bufferSize)) {
+                return static_cast<int32_t>(i);
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USER_BUFFER_POOL_HPP
+#define USER_BUFFER_POOL_HPP
+
+#include "cluon-complete.hpp"
+#include "frame.hpp"
+#include "shared-memory-layout.hpp"
+
+#include <Spinnaker.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Pool of camera stream buffers carved from a shared memory area so that
+ * frames in the camera's native format land directly in shared memory.
+ * Publishing a frame only updates the index of the latest slot in the
+ * area's trailer; the published frame is held until the next one replaces
+ * it and is then returned to the camera's stream.
+ */
+class UserBufferPool {
+   private:
+    UserBufferPool(const UserBufferPool &) = delete;
+    UserBufferPool(UserBufferPool &&)      = delete;
+    UserBufferPool &operator=(const UserBufferPool &) = delete;
+    UserBufferPool &operator=(UserBufferPool &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param name Name of the shared memory area.
+     * @param bufferCount Number of stream buffers (at most layout::MAX_SLOTS).
+     * @param bufferSize Size of one stream buffer (at least the camera's payload size).
+     * @param width Width of a frame.
+     * @param height Height of a frame.
+     * @param fourcc Pixel format of a frame.
+     */
+    UserBufferPool(const std::string &name, uint32_t bufferCount, uint32_t bufferSize, uint32_t width, uint32_t height, uint32_t fourcc) noexcept;
+    ~UserBufferPool();
+
+   public:
+    bool valid() noexcept;
+    std::string name() const noexcept;
+    uint32_t size() const noexcept;
+
+    /**
+     * This method registers the pool's buffers as the camera's stream buffers;
+     * it must be called before the acquisition is started.
+     *
+     * @param camera Camera to register the buffers with.
+     */
+    void attach(Spinnaker::CameraPtr camera);
+
+    /**
+     * This method publishes a frame residing in one of the pool's buffers and
+     * returns the previously published frame to the camera's stream.
+     *
+     * @param frame Frame to publish; ownership is taken over.
+     * @param ts Sample time stamp.
+     * @return false if the frame does not belong to this pool.
+     */
+    bool publish(Frame &frame, const cluon::data::TimeStamp &ts) noexcept;
+
+    /**
+     * This method returns the currently published frame to the camera's stream.
+     */
+    void release() noexcept;
+
+   private:
+    int32_t slotOf(const Frame &frame) noexcept;
+
+   private:
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory{nullptr};
+    layout::Trailer *m_trailer{nullptr};
+    std::vector<void *> m_buffers{};
+    uint32_t m_bufferSize{0};
+    uint64_t m_sequence{0};
+    Frame m_published{};
+    int32_t m_publishedSlot{-1};
+};
+
+#endif
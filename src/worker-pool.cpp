@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worker-pool.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <iostream>
+
+WorkerPool::WorkerPool(uint32_t threads, const std::vector<int32_t> &cpus) noexcept
+    : m_cpus{cpus} {
+    for (uint32_t i{1}; i < threads; i++) {
+        m_workers.push_back(std::thread(&WorkerPool::work, this, i));
+        if (!m_cpus.empty()) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(m_cpus[i % m_cpus.size()], &cpuset);
+            if (0 != pthread_setaffinity_np(m_workers.back().native_handle(), sizeof(cpu_set_t), &cpuset)) {
+                std::cerr << "[opendlv-device-camera-spinnaker]: Could not pin conversion thread " << i << " to CPU " << m_cpus[i % m_cpus.size()] << "." << std::endl;
+            }
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+uint32_t WorkerPool::size() const noexcept {
+    return static_cast<uint32_t>(m_workers.size() + 1);
+}
+
+void WorkerPool::pinCaller() const noexcept {
+    if (m_cpus.empty()) {
+        return;
+    }
+    // With several cameras, the callers take turns and may run on any CPU of
+    // the pool while the workers are idle.
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (auto cpu : m_cpus) {
+        CPU_SET(cpu, &cpuset);
+    }
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
+        std::cerr << "[opendlv-device-camera-spinnaker]: Could not pin conversion thread 0 to the CPUs of the pool." << std::endl;
+    }
+}
+
+void WorkerPool::parallelFor(uint32_t count, const std::function<void(uint32_t)> &task) noexcept {
+    if (m_workers.empty() || (2 > count)) {
+        for (uint32_t i{0}; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> caller(m_callerMutex);
+    {
+        // Late workers of the previous round must have left before the task is replaced.
+        std::unique_lock<std::mutex> lck(m_mutex);
+        m_done.wait(lck, [this]() { return 0 == m_active; });
+        m_task  = &task;
+        m_count = count;
+        m_next.store(0);
+        m_pending.store(count);
+        m_generation++;
+    }
+    m_wakeup.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lck(m_mutex);
+    m_done.wait(lck, [this]() { return 0 == m_pending.load(); });
+}
+
+void WorkerPool::work(uint32_t) noexcept {
+    uint64_t generation{0};
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            m_wakeup.wait(lck, [this, &generation]() { return m_stop || (generation != m_generation); });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            m_active++;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_active--;
+        }
+        m_done.notify_all();
+    }
+}
+
+void WorkerPool::runTasks() noexcept {
+    for (;;) {
+        const uint32_t i{m_next.fetch_add(1)};
+        if (i >= m_count) {
+            break;
+        }
+        (*m_task)(i);
+        if (1 == m_pending.fetch_sub(1)) {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
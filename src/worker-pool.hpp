@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019-2021  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Persistent pool of threads to run the stripes of a frame in parallel.
+ * The calling thread takes part in the work, so a pool of size N spawns
+ * N-1 worker threads.
+ */
+class WorkerPool {
+   private:
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool(WorkerPool &&)      = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    WorkerPool &operator=(WorkerPool &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param threads Number of threads working on a frame (including the caller).
+     * @param cpus CPUs to work on; empty for no pinning. The worker threads
+     *             are pinned to the second, third, ... CPU (round robin) and
+     *             the callers to all of them (cf. pinCaller).
+     */
+    WorkerPool(uint32_t threads, const std::vector<int32_t> &cpus) noexcept;
+    ~WorkerPool();
+
+   public:
+    /**
+     * @return Number of threads working on a frame.
+     */
+    uint32_t size() const noexcept;
+
+    /**
+     * This method pins the calling thread to the CPUs of the pool; the first
+     * CPU is left to the callers as they work on a share of every frame.
+     */
+    void pinCaller() const noexcept;
+
+    /**
+     * This method runs task(i) for all i in [0, count) and returns once all
+     * of them have completed. Concurrent callers (e.g., the conversion
+     * threads of several cameras) take turns.
+     *
+     * @param count Number of tasks.
+     * @param task Task to run.
+     */
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)> &task) noexcept;
+
+   private:
+    void work(uint32_t index) noexcept;
+    void runTasks() noexcept;
+
+   private:
+    std::vector<std::thread> m_workers{};
+    std::vector<int32_t> m_cpus{};
+
+    std::mutex m_callerMutex{};
+    std::mutex m_mutex{};
+    std::condition_variable m_wakeup{};
+    std::condition_variable m_done{};
+    bool m_stop{false};
+    uint64_t m_generation{0};
+    uint32_t m_active{0};
+
+    const std::function<void(uint32_t)> *m_task{nullptr};
+    uint32_t m_count{0};
+    std::atomic<uint32_t> m_next{0};
+    std::atomic<uint32_t> m_pending{0};
+};
+
+/**
+ * @param stripe Index of the stripe.
+ * @param stripes Number of stripes.
+ * @param height Height of the frame.
+ * @return [first, last) rows of a horizontal stripe; all boundaries but the
+ *         frame's end are even to keep 4:2:0 chroma rows intact.
+ */
+inline std::pair<uint32_t, uint32_t> stripeRows(uint32_t stripe, uint32_t stripes, uint32_t height) noexcept {
+    const uint32_t ROW_PAIRS{(height + 1) / 2};
+    const uint32_t FIRST{2 * static_cast<uint32_t>((static_cast<uint64_t>(ROW_PAIRS) * stripe) / stripes)};
+    const uint32_t LAST{2 * static_cast<uint32_t>((static_cast<uint64_t>(ROW_PAIRS) * (stripe + 1)) / stripes)};
+    return std::make_pair(FIRST, (LAST < height) ? LAST : height);
+}
+
+#endif